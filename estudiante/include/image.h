@@ -8,19 +8,34 @@
 #define _IMAGEN_H_
 
 
+#include <atomic>
 #include <cstdlib>
+#include <mutex>
 #include "imageIO.h"
+#include "imageView.h"
+#include "imageHistogram.h"
+#include "integralImage.h"
 
 
-
-typedef unsigned char byte;
-
 enum LoadResult: unsigned char {
     SUCCESS,
     NOT_PGM,
     READING_ERROR
 };
 
+/**
+  @brief Forma de cargar una imagen de disco.
+
+  - LOAD_COPY: los píxeles se leen a un buffer propio de la imagen.
+  - LOAD_MAP: la imagen apunta directamente a los píxeles del archivo proyectado en memoria (ver MapPGMImage).
+    La carga no copia nada y varias imágenes del mismo archivo comparten las páginas de la caché del sistema.
+    Cada página se duplica solo la primera vez que se modifica un píxel suyo.
+**/
+enum LoadMode: unsigned char {
+    LOAD_COPY,
+    LOAD_MAP
+};
+
 
 /**
   @brief T.D.A. Imagen
@@ -61,21 +76,50 @@ private :
     /**
       @brief Puntero a la imagen almacenada
 
-      img apunta a un array-2D dinámico de bytes que contiene la imagen en sí. Almacena tantos bytes como pixeles tenga la imagen.
+      img apunta a un único buffer contiguo de bytes, alineado a línea de caché, que contiene la imagen en sí.
+      Almacena tantos bytes como pixeles tenga la imagen, fila a fila: la fila @e i comienza en
+      img + i*cols, es decir, la separación entre filas (stride) es igual al número de columnas.
 
     **/
-    byte **img;
+    byte *img;
 
     /**
       @brief Número de filas de la imagen.
     **/
-    int rows;
+    ptrdiff_t rows;
 
 
     /**
       @brief Número de columnas de la imagen.
     **/
-    int cols;
+    ptrdiff_t cols;
+
+    /**
+      @brief Proyección del archivo de la que proceden los píxeles.
+
+      Si la imagen se cargó con LOAD_MAP, img apunta dentro de esta proyección y no a un buffer reservado con
+      AllocateBuffer. En otro caso mapping.base vale 0.
+    **/
+    PGMMapping mapping;
+
+    /**
+      @brief Imagen integral de la imagen, usada para calcular medias de regiones en O(1).
+
+      Se construye la primera vez que se necesita y solo es válida mientras index_valid sea true.
+    **/
+    mutable IntegralImage index;
+
+    /**
+      @brief Indica si index corresponde a los píxeles actuales de la imagen.
+
+      Cualquier operación que dé acceso de escritura a los píxeles lo pone a false.
+    **/
+    mutable std::atomic<bool> index_valid;
+
+    /**
+      @brief Protege la construcción de index, que puede pedirse desde métodos const en varios hilos.
+    **/
+    mutable std::mutex index_lock;
 
 
     /**
@@ -86,14 +130,39 @@ private :
       @pre filas >= O y columnas >= O
       @post Reserva memoria para almacenar la imagen y la prepara para usarse.
     **/
-    void Initialize (int nrows= 0, int ncols= 0, byte *buffer= 0);
+    void Initialize (ptrdiff_t nrows= 0, ptrdiff_t ncols= 0, byte *buffer= 0);
 
     /**
       @brief Lee una imagen PGM desde un archivo.
       @param file_path Ruta del archivo a leer
+      @param mode Forma de cargar la imagen. Si la proyección no es posible se lee el archivo.
       @return LoadResult
     **/
-    LoadResult LoadFromPGM(const char * file_path);
+    LoadResult LoadFromPGM(const char * file_path, LoadMode mode);
+
+    /**
+      @brief Sustituye los píxeles de la imagen por un buffer ya relleno.
+      @param buffer Buffer reservado con AllocateBuffer, del que la imagen pasa a ser propietaria.
+      @param nrows Número de filas del buffer.
+      @param ncols Número de columnas del buffer.
+      @post Los píxeles anteriores se liberan.
+    **/
+    void Adopt(byte * buffer, ptrdiff_t nrows, ptrdiff_t ncols);
+
+    /**
+      @brief Reordena las filas en su sitio: la fila i pasa a ser la fila perm(i) anterior.
+      @param perm Función que, para cada fila i de la imagen resultado, devuelve su fila de origen.
+      @pre perm es una biyección de [0, get_rows()) en sí mismo.
+      @post Memoria adicional: un bit y una fila. Cada fila se copia como mucho una vez más.
+    **/
+    template <typename Perm>
+    void PermuteRowsWith(Perm perm);
+
+    /**
+      @brief ShuffleRows cuando @p P no es coprimo con el número de filas.
+      @param P Multiplicador.
+    **/
+    void ShuffleRowsCopy(ptrdiff_t P);
 
     /**
       @brief Copy una imagen .
@@ -109,15 +178,17 @@ private :
       @param ncols Número de colwnnas que tendrá la imagen.
       @param buffer Puntero a un buffer de datos con los que rellenar los píxeles de la imagen. Por defecto, 0.
       @pre nrows >= O y ncols >= O
-      @post Reserva memoria para almacenar la imagen y la prepara para usarse.
+      @post Reserva memoria para almacenar la imagen y la prepara para usarse. Se hace una única reserva
+      y, si hay @p buffer, una única copia.
     **/
-    void Allocate(int nrows, int ncols, byte * buffer = 0);
+    void Allocate(ptrdiff_t nrows, ptrdiff_t ncols, byte * buffer = 0);
 
     /**
       * @brief Destroy una imagen
       *
       * Libera la memoria reservada en la que se almacenaba la imagen que llama a la función.
       * Si la imagen estaba vacía no hace nada .
+      * @post La imagen queda vacía (0 filas y 0 columnas).
       */
     void Destroy();
 
@@ -139,7 +210,7 @@ public :
       * @post La imagen creada es de n_fils y n_cols columnas. Estará inicializada al valor por defecto.
       * @return Imagen, el objeto imagen creado.
       */
-    Image(int nrows, int ncols, byte value=0);
+    Image(ptrdiff_t nrows, ptrdiff_t ncols, byte value=0);
 
     /**
       * @brief Constructor de copias.
@@ -148,6 +219,22 @@ public :
       */
     Image (const Image & orig);
 
+    /**
+      * @brief Constructor a partir de una vista.
+      * @param view Vista (de esta u otra imagen) cuyos píxeles se copian.
+      * @return Imagen, el objeto imagen creado, con las dimensiones de @p view.
+      * @post La imagen creada es independiente de la imagen a la que apunta @p view.
+      */
+    Image (const ImageView & view);
+
+    /**
+      * @brief Constructor de movimiento.
+      * @param orig Imagen de la que se toman los píxeles.
+      * @return Imagen, el objeto imagen creado.
+      * @post La imagen creada se queda con el buffer de @p orig sin copiarlo. @p orig queda vacía.
+      */
+    Image (Image && orig) noexcept;
+
     /**
       * @brief Oper ador de tipo destructor.
       * @return void
@@ -163,6 +250,22 @@ public :
       */
     Image & operator= (const Image & orig);
 
+    /**
+      * @brief Operador de asignación por movimiento.
+      * @param orig Imagen de la que se toman los píxeles.
+      * @return Una referencia al objeto imagen modificado.
+      * @post Destroy cualquier información que contuviera previamente la imagen. Esta se queda con el
+      * buffer de @p orig sin copiarlo y @p orig queda vacía.
+      */
+    Image & operator= (Image && orig) noexcept;
+
+    /**
+      * @brief Intercambia el contenido de dos imágenes.
+      * @param other Imagen con la que intercambiar.
+      * @post Solo se intercambian los punteros y las dimensiones; no se copia ni se reserva nada.
+      */
+    void swap (Image & other) noexcept;
+
     /**
       * @brief Funcion para conocer si una imagen está vacía.
       * @return Si la imagene está vacía
@@ -170,26 +273,55 @@ public :
       */
     bool Empty() const;
 
+    /**
+      * @brief Vista de solo lectura de toda la imagen.
+      * @return Una vista que apunta a los píxeles de la imagen, sin copiarlos.
+      * @post la imagen no se modifica. La vista deja de ser válida si la imagen se destruye o se reasigna.
+      */
+    ImageView View() const;
+
+    /**
+      * @brief Vista modificable de toda la imagen.
+      * @return Una vista que apunta a los píxeles de la imagen, sin copiarlos.
+      * @post La vista deja de ser válida si la imagen se destruye o se reasigna.
+      * @post Invalida la imagen integral (ver get_integral()). Si se escribe a través de la vista después de
+      * volver a consultar la imagen integral, hay que pedir otra vista para que se invalide de nuevo.
+      */
+    MutableImageView MutableView();
+
+    /**
+      * @brief Imagen integral de la imagen.
+      *
+      * Se construye en la primera llamada (O(filas*columnas)) y se reutiliza en las siguientes mientras
+      * no se modifique ningún píxel. Cualquier escritura (set_pixel, MutableView, Invert, ...) la invalida
+      * y la siguiente llamada la reconstruye.
+      * @return Referencia a la imagen integral, válida hasta la siguiente modificación de la imagen.
+      * @post la imagen no se modifica.
+      * @note Varios hilos pueden llamarla a la vez sobre la misma imagen: solo uno la construye y los demás
+      * esperan a que termine.
+      */
+    const IntegralImage & get_integral() const;
+
     /**
       * @brief Filas de la imagen .
       * @return El número de filas de la i magen.
       * @post la imagen no se modifica.
       */
-    int get_rows() const;
+    ptrdiff_t get_rows() const;
 
     /**
       * @brief Columnas de la imagen.
       * @return El número de columnas de la imagen.
       * @post la imagen no se modifica.
       */
-    int get_cols() const;
+    ptrdiff_t get_cols() const;
 
     /**
       * @brief Devuelve el número de píxeles de la imagen.
       * @return número de píxeles de la imagen.
       * @post la imagen no se modifica.
       */
-    int size() const;
+    size_t size() const;
 
 /**
   * @brief Asigna el valor valor al píxel (@p i, @p j) de la imagen.
@@ -202,7 +334,7 @@ public :
   * @post El píxel (@p i, @p j) de la imagen se modificará y contendrá valor @p value.
   * Los demás píxeles permanecerán iguales.
   */
-void set_pixel (int i, int j, byte value);
+void set_pixel (ptrdiff_t i, ptrdiff_t j, byte value);
 
     /**
       * @brief Consulta el valor del píxel (fil, col) de la imagen.
@@ -212,7 +344,7 @@ void set_pixel (int i, int j, byte value);
       * @return el valor del píxel contenido en (fil,col)
       * @post La imagen no se modifica.
       */
-    byte get_pixel (int i, int j) const;
+    byte get_pixel (ptrdiff_t i, ptrdiff_t j) const;
 
     /**
       * @brief Consulta el valor del píxel k de la imagen desenrrollada.
@@ -221,7 +353,7 @@ void set_pixel (int i, int j, byte value);
       * @return el valor del píxel contenido en (k/filas,k%filas)
       * @post La imagen no se modifica.
       */
-    byte get_pixel (int k) const;
+    byte get_pixel (ptrdiff_t k) const;
 
     /**
       * @brief Asigna el valor valor al píxel k de la imagen desenrollada.
@@ -230,38 +362,58 @@ void set_pixel (int i, int j, byte value);
       * @pre 0 <= k < filas*columnas && O <= valor <= 255
       * @post El píxel k se modificará con el valor de value.
       */
-    void set_pixel (int k, byte value);
+    void set_pixel (ptrdiff_t k, byte value);
 
     /**
       * @brief Almacena imágenes en disco.
+      *
+      * Los píxeles se escriben directamente desde el buffer de la imagen, sin copias intermedias.
       * @param file_path Ruta donde se almacenará la imagen.
+      * @param mode Combinación de valores de SaveMode: SAVE_SYNC espera a que los datos estén en disco y
+      * SAVE_ATOMIC sustituye el archivo de golpe, de modo que nunca queda una imagen a medio escribir.
       * @pre file path debe ser una ruta válida donde almacenar el fichero de salida.
       * @return Devuelve true si la imagen se almacenó con éxito y false en caso contrario.
       * @post La imagen no se modifica.
+      * @note Para guardar sobre el mismo archivo del que se cargó con LOAD_MAP hay que usar SAVE_ATOMIC.
       */
-    bool Save (const char * file_path) const;
+    bool Save (const char * file_path, unsigned mode = SAVE_DEFAULT) const;
 
     /**
       * @brief Carga en memoria una imagen de disco .
       * @param file_path Ruta donde se encuentra el archivo desde el que cargar la imagen.
+      * @param mode Forma de cargar la imagen: copiándola (por defecto) o proyectando el archivo en memoria.
       * @pre @p file_path debe ser una ruta válida que contenga un fichero . pgm
       * @return Devuelve @b true si la imagen se carga con éxito y @b false en caso contrario.
       * @post La imagen previamente almacenada en el objeto que llama a la función se destruye.
       */
-    bool Load (const char * file_path);
+    bool Load (const char * file_path, LoadMode mode = LOAD_COPY);
 
     // Invierte
     /**
     * @brief Genera una imagen con la tonalidad de colores inversa a partir de una imagen dada
+    *
+    * Recorre el buffer contiguo con el núcleo vectorizado InvertRow (ver imageSimd.h).
     * @pre Solo funciona para imágenes en blanco y negro
     * @return Devuelve la imagen modificada
     * @post La imagen original no se modifica
     */
     void Invert();
 
+    /**
+    * @brief Sustituye cada píxel de la imagen por su valor en una tabla de consulta
+    *
+    * Sirve para cualquier operación puntual (el nuevo valor de un píxel solo depende de su valor
+    * anterior). La tabla se aplica con el núcleo vectorizado ApplyLUTRow (ver imageSimd.h).
+    * @param lut Tabla de 256 entradas: el píxel de valor v pasa a valer lut[v]
+    * @post La imagen queda modificada
+    */
+    void ApplyLUT(const byte lut[256]);
+
     // Modifica el contraste de una Imagen .
      /**
      * @brief Ajusta el contraste de una imagen
+     *
+     * Se calcula la tabla de 256 valores del ajuste (ver ContrastLUT) y se aplica con ApplyLUT.
      * @param in1 Umbral inferior de la image de entrada
      * @param in2 Umbral superior de la imagen de entrada
      * @param out1 Umbral inferior de la imagen de salida
@@ -273,9 +425,38 @@ void set_pixel (int i, int j, byte value);
      */
     void AdjustContrast (byte in1, byte in2, byte out1, byte out2);
 
+    /**
+     * @brief Ajusta el contraste de una imagen sin indicar umbrales
+     *
+     * Los umbrales de entrada de AdjustContrast son los percentiles @p low y @p high del histograma
+     * (ver Histogram), y los de salida 0 y 255: los niveles entre ambos percentiles se estiran a todo el
+     * rango. La imagen se lee dos veces, una para el histograma y otra para aplicar la tabla (ver
+     * AutoContrastLUT).
+     * @param low Percentil que pasa a ser el negro, entre 0 y 100
+     * @param high Percentil que pasa a ser el blanco, entre 0 y 100
+     * @pre @p low < @p high
+     * @post La imagen queda modificada. Si es casi uniforme (los dos percentiles coinciden) no cambia.
+     */
+    void AutoContrast (double low = 1, double high = 99);
+
+    /**
+     * @brief Ecualiza el histograma de una imagen
+     *
+     * Cada nivel pasa a ser proporcional al número de píxeles menores o iguales que él, de modo que los
+     * niveles del resultado se reparten lo más uniformemente posible (ver EqualizeLUT). Como AutoContrast,
+     * lee la imagen dos veces.
+     * @post La imagen queda modificada. Si tiene un solo nivel no cambia.
+     */
+    void Equalize ();
+
     // Calcula la media de los píxeles de una imagen entera o de un fragmento de ésta.
     /**
      * @brief Calcula la media de los píxeles de una imagen entera o de un fragmento de ésta
+     *
+     * Si la imagen integral ya está construida (ver get_integral()) se resuelve con cuatro consultas, sin
+     * recorrer el fragmento. Si no, se suman los píxeles del fragmento sin construirla: una consulta aislada
+     * no paga la tabla. Para muchas consultas sobre la misma imagen conviene llamar antes a get_integral().
+     * Puede llamarse desde varios hilos a la vez.
      * @param i Fila de la esquina superior izquierda de la sección de imagen que se procesará
      * @param j Columna de la esquina superior izquierda de la sección de imagen que se procesará
      * @param height Altura de la sección de imagen que se procesará
@@ -285,11 +466,25 @@ void set_pixel (int i, int j, byte value);
      * @pre 0 <= @p i + @p height < get_rows()
      * @pre 0 <= @p j + @p width < get_cols()
      */
-    double Mean (int i, int j, int height, int width) const;
+    double Mean (ptrdiff_t i, ptrdiff_t j, ptrdiff_t height, ptrdiff_t width) const;
+
+    /**
+     * @brief Calcula el histograma de la imagen
+     *
+     * Se recorre la imagen una sola vez, repartida entre hilos; el mínimo, el máximo, los percentiles,
+     * la media y la varianza se obtienen después del histograma sin volver a leer la imagen (ver
+     * ImageHistogram).
+     * @return Histograma de los 256 niveles de gris
+     * @post La imagen original no se modifica
+     */
+    ImageHistogram Histogram () const;
 
     // Genera un icono como reducción de una imagen.
     /**
      * @brief Genera una imagen reducida en función del valor introducido a partir de la imagen dada
+     *
+     * Cada píxel es la media redondeada de un bloque @p factor x @p factor, calculada con sumas enteras de
+     * filas completas (ver BoxDownsample en imageScale.h).
      * @param factor Valor de reducción de la imagen (ej: factor=2 => width= ncols/2 )
      * @pre @p factor > 0
      * @return Devuelve la imagen modificada
@@ -298,11 +493,14 @@ void set_pixel (int i, int j, byte value);
      * @post La imagen original no se modifica
      */
 
-    Image Subsample(int factor) const;
+    Image Subsample(ptrdiff_t factor) const;
 
     // Genera una subimagen.
     /**
      * @brief Genera una subimagen a partir de la imagen dada.
+     *
+     * La subimagen es una vista sobre los píxeles de la imagen original, por lo que no se reserva ni se
+     * copia memoria. Para obtener una imagen independiente basta con construir un Image a partir de ella.
      * @param nrow Número de fila donde se coloca la esquina izquierda de la subimagen
      * @param ncol Número de columna donde se coloca la esquina izquierda de la subimagen
      * @param height Altura de la subimagen = número de filas
@@ -311,9 +509,9 @@ void set_pixel (int i, int j, byte value);
      * @return Devuelve la subimagen
      * @post En caso de que el tamaño de la subimagen sobrepase los límites de la imagen original,
      * se ajustará su tamaño.
-     * @post La imagen original no se modifica
+     * @post La imagen original no se modifica. La subimagen solo es válida mientras lo sea la imagen original.
      */
-    Image Crop(int nrow, int ncol, int height, int width) const;
+    ImageView Crop(ptrdiff_t nrow, ptrdiff_t ncol, ptrdiff_t height, ptrdiff_t width) const;
 
     // Aumenta una imagen a x2
     /**
@@ -323,15 +521,111 @@ void set_pixel (int i, int j, byte value);
      */
     Image Zoom2X() const;
 
+    // Cambia el tamaño de una imagen.
+    /**
+     * @brief Genera una imagen escalada a unas dimensiones cualesquiera a partir de la imagen dada
+     *
+     * A diferencia de Zoom2X y Subsample, el factor de escala no tiene por qué ser entero y puede ser
+     * distinto en cada dirección (ver Resample en imageScale.h).
+     * @param new_rows Filas de la imagen resultado
+     * @param new_cols Columnas de la imagen resultado
+     * @param filter Filtro de interpolación: RESIZE_BILINEAR (por defecto), RESIZE_BICUBIC o RESIZE_LANCZOS3
+     * @pre @p new_rows > 0 y @p new_cols > 0
+     * @return Devuelve la imagen escalada
+     * @post La imagen original no se modifica
+     */
+    Image Resize(ptrdiff_t new_rows, ptrdiff_t new_cols, ResizeFilter filter = RESIZE_BILINEAR) const;
+
     // Baraja pseudoaleatoriamente las filas de una imagen.
     /**
      * @brief Modifica el orden de las filas de la imagen tomando un coprimo del número de filas de la misma
+     *
+     * La fila i de la imagen resultado es la fila i*@p P % get_rows() de la original. Las filas se mueven
+     * en su sitio siguiendo los ciclos de la permutación, sin reservar otra imagen.
+     * @param P Multiplicador. Si no es coprimo con el número de filas, varias filas se sustituyen por la
+     * misma y la operación no puede deshacerse (ni hacerse en el sitio).
+     * @pre @p P > 0
+     * @post La imagen original sí se modifica
+     * @see UnshuffleRows
+     */
+    void ShuffleRows(ptrdiff_t P = 9973);
+
+    /**
+     * @brief Deshace ShuffleRows
+     * @param P El mismo multiplicador que se usó en ShuffleRows.
+     * @return false, sin modificar la imagen, si @p P no es coprimo con el número de filas: entonces
+     * ShuffleRows no puede deshacerse.
+     * @post La fila i*@p P % get_rows() de la imagen resultado es la fila i de la actual.
+     */
+    bool UnshuffleRows(ptrdiff_t P = 9973);
+
+    /**
+     * @brief Reordena las filas de la imagen según una permutación arbitraria
+     * @param perm Tabla de get_rows() posiciones: la fila i de la imagen resultado es la fila @p perm[i] de
+     * la original.
+     * @pre @p perm es una permutación de 0, ..., get_rows()-1
+     * @post La imagen original sí se modifica
+     */
+    void PermuteRows(const ptrdiff_t * perm);
+
+    /**
+     * @brief Baraja las columnas de la imagen: la columna j pasa a ser la columna j*@p P % get_cols()
+     *
+     * Equivale a ShuffleRows sobre las columnas, pero se procesa fila a fila (ver PermuteColumns en
+     * imageTransform.h), sin recorrer la imagen por columnas.
+     * @param P Multiplicador.
+     * @pre @p P > 0
+     * @post La imagen original sí se modifica
+     * @see UnshuffleCols
+     */
+    void ShuffleCols(ptrdiff_t P = 9973);
+
+    /**
+     * @brief Deshace ShuffleCols
+     * @param P El mismo multiplicador que se usó en ShuffleCols.
+     * @return false, sin modificar la imagen, si @p P no es coprimo con el número de columnas.
+     */
+    bool UnshuffleCols(ptrdiff_t P = 9973);
+
+    /**
+     * @brief Reordena las columnas de la imagen según una permutación arbitraria
+     * @param perm Tabla de get_cols() posiciones: la columna j de la imagen resultado es la columna
+     * @p perm[j] de la original.
+     * @pre @p perm es una permutación de 0, ..., get_cols()-1
      * @post La imagen original sí se modifica
      */
-    void ShuffleRows();
+    void PermuteCols(const ptrdiff_t * perm);
+
+    /**
+     * @brief Genera la imagen traspuesta: el píxel (i, j) pasa a (j, i)
+     *
+     * Se recorre por bloques para aprovechar la caché (ver Transpose en imageTransform.h).
+     * @return Imagen de get_cols() filas y get_rows() columnas
+     * @post La imagen original no se modifica
+     */
+    Image Transpose() const;
+
+    /**
+     * @brief Genera la imagen girada en el sentido de las agujas del reloj
+     * @param degrees Ángulo de giro: 90, 180, 270 o cualquier múltiplo de 90 (los negativos giran en
+     * sentido contrario).
+     * @pre @p degrees es múltiplo de 90
+     * @return Imagen girada. Con giros de 90 y 270 grados se intercambian filas y columnas.
+     * @post La imagen original no se modifica
+     */
+    Image Rotate(int degrees) const;
 
 } ;
 
+/**
+  * @brief Intercambia el contenido de dos imágenes sin copiar sus píxeles.
+  * @param a Primera imagen.
+  * @param b Segunda imagen.
+  */
+inline void swap (Image & a, Image & b) noexcept {
+    a.swap(b);
+}
+
 
 #endif // _IMAGEN_H_
 
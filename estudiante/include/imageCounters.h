@@ -0,0 +1,109 @@
+/**
+  * @file imageCounters.h
+  * @brief Fichero cabecera para la lectura de contadores hardware del procesador
+  *
+  * En Linux los contadores se abren con perf_event_open y cuentan solo en modo usuario
+  * y en el hilo que crea el objeto. Si el sistema no los ofrece (otro sistema operativo,
+  * máquina virtual sin PMU, o perf_event_paranoid demasiado restrictivo) el objeto queda
+  * sin contadores disponibles y las mediciones no hacen nada, de modo que el código que
+  * los usa no necesita comprobaciones previas.
+  *
+  */
+
+#ifndef _IMAGEN_CONTADORES_H_
+#define _IMAGEN_CONTADORES_H_
+
+/**
+  * @brief Eventos que se pueden contar
+  */
+enum CounterEvent {
+  COUNTER_CYCLES,          ///< Ciclos de reloj
+  COUNTER_INSTRUCTIONS,    ///< Instrucciones ejecutadas
+  COUNTER_L1D_MISSES,      ///< Fallos de lectura en la caché L1 de datos
+  COUNTER_LLC_MISSES,      ///< Fallos en la caché de último nivel
+  COUNTER_BRANCH_MISSES,   ///< Saltos mal predichos
+  COUNTER_DTLB_MISSES,     ///< Fallos de lectura en la TLB de datos
+  COUNTER_EVENTS           ///< Número de eventos
+};
+
+/**
+  * @brief Nombre corto de un evento, para informes
+  *
+  * @param event evento
+  * @return nombre del evento (por ejemplo, "cycles").
+  */
+const char * CounterName (CounterEvent event);
+
+/**
+  @brief Grupo de contadores hardware del hilo que lo crea
+
+  Uso típico:
+  @code
+    PerfCounters counters;
+    counters.Start();
+    image.Invert();
+    counters.Stop();
+    if (counters.Available(COUNTER_CYCLES))
+      cout << counters.Value(COUNTER_CYCLES);
+  @endcode
+
+  Los eventos se abren por separado: si el procesador no ofrece alguno, los demás siguen
+  disponibles. Si el núcleo reparte los contadores en el tiempo (más eventos que contadores
+  físicos), los valores se escalan a todo el intervalo medido.
+**/
+class PerfCounters {
+
+  private:
+
+    int fd[COUNTER_EVENTS];                          ///< Descriptor de cada evento (-1 = no disponible)
+    unsigned long long values[COUNTER_EVENTS];       ///< Valores del último intervalo medido
+
+    PerfCounters (const PerfCounters&);              // No se puede copiar
+    PerfCounters& operator= (const PerfCounters&);
+
+  public:
+
+    /**
+      * @brief Abre los contadores disponibles, sin empezar a contar
+      */
+    PerfCounters ();
+
+    /**
+      * @brief Cierra los contadores
+      */
+    ~PerfCounters ();
+
+    /**
+      * @brief Comprueba si hay algún contador disponible
+      * @return true si se pudo abrir al menos un evento.
+      */
+    bool Available () const;
+
+    /**
+      * @brief Comprueba si un evento está disponible
+      * @param event evento
+      * @return true si el evento se pudo abrir.
+      */
+    bool Available (CounterEvent event) const;
+
+    /**
+      * @brief Pone los contadores a cero y empieza a contar
+      */
+    void Start ();
+
+    /**
+      * @brief Deja de contar y guarda los valores del intervalo
+      */
+    void Stop ();
+
+    /**
+      * @brief Valor de un evento en el último intervalo medido
+      * @param event evento
+      * @return número de eventos entre el último Start y Stop (0 si no está disponible).
+      */
+    unsigned long long Value (CounterEvent event) const;
+};
+
+#endif
+
+/* Fin Fichero: imageCounters.h */
@@ -0,0 +1,180 @@
+/**
+ * @file imageHistogram.h
+ * @brief Cabecera para la clase ImageHistogram
+ */
+
+#ifndef _IMAGEN_HISTOGRAMA_H_
+#define _IMAGEN_HISTOGRAMA_H_
+
+#include "imageView.h"
+
+
+/**
+  @brief T.D.A. Histograma de una imagen
+
+  Una instancia de ImageHistogram almacena cuántos píxeles de la imagen original tienen cada uno de los
+  256 niveles de gris. Se construye con un único recorrido de la imagen, repartido entre hilos (ver
+  imageThreads.h); al terminar se calculan a partir de los 256 contadores el mínimo, el máximo, la media,
+  la varianza y el histograma acumulado, de modo que todas las consultas son O(1) (los percentiles,
+  O(log 256)).
+
+  Como la tabla de IntegralImage, el histograma no se actualiza si la imagen original cambia.
+
+**/
+
+class ImageHistogram{
+
+private :
+
+    /**
+      @brief Número de píxeles de cada nivel de gris.
+    **/
+    unsigned long long bins[256];
+
+    /**
+      @brief Histograma acumulado: cumulative[v] es el número de píxeles de nivel menor o igual que v.
+    **/
+    unsigned long long cumulative[256];
+
+    /**
+      @brief Número total de píxeles (cumulative[255]).
+    **/
+    unsigned long long total;
+
+    /**
+      @brief Menor y mayor nivel presentes en la imagen.
+    **/
+    byte lowest, highest;
+
+    /**
+      @brief Media y varianza de los niveles de la imagen.
+    **/
+    double mean, variance;
+
+    /**
+      @brief Calcula el histograma acumulado y los estadísticos a partir de bins.
+    **/
+    void Summarize();
+
+public :
+
+    /**
+      * @brief Constructor por defecto.
+      * @post Genera el histograma de una imagen vacía.
+      */
+    ImageHistogram();
+
+    /**
+      * @brief Construye el histograma de una imagen.
+      * @param view Imagen (o región) cuyos píxeles se cuentan.
+      */
+    explicit ImageHistogram(const ImageView & view);
+
+    /**
+      * @brief Reconstruye el histograma para otra imagen.
+      * @param view Imagen (o región) cuyos píxeles se cuentan.
+      * @post El histograma anterior se descarta.
+      */
+    void Build(const ImageView & view);
+
+    /**
+      * @brief Añade al histograma los píxeles de otra imagen.
+      *
+      * Permite construir el histograma de una imagen que se lee por bloques de filas (ver imageStream.h).
+      * @param view Imagen (o región) cuyos píxeles se cuentan.
+      * @post El histograma cuenta los píxeles anteriores más los de @p view.
+      */
+    void Add(const ImageView & view);
+
+    /**
+      * @brief Número de píxeles de un nivel de gris.
+      * @param value Nivel de gris.
+      * @return Número de píxeles de la imagen con valor @p value.
+      */
+    unsigned long long operator[](byte value) const;
+
+    /**
+      * @brief Número de píxeles hasta un nivel de gris.
+      * @param value Nivel de gris.
+      * @return Número de píxeles de la imagen con valor menor o igual que @p value.
+      */
+    unsigned long long Cumulative(byte value) const;
+
+    /**
+      * @brief Número de píxeles contados.
+      * @return El número de píxeles de la imagen (filas x columnas).
+      */
+    unsigned long long get_total() const;
+
+    /**
+      * @brief Comprueba si el histograma está vacío.
+      * @return true si no se ha contado ningún píxel.
+      */
+    bool Empty() const;
+
+    /**
+      * @brief Menor nivel de gris de la imagen.
+      * @pre El histograma no está vacío.
+      * @return El valor del píxel más oscuro.
+      */
+    byte Min() const;
+
+    /**
+      * @brief Mayor nivel de gris de la imagen.
+      * @pre El histograma no está vacío.
+      * @return El valor del píxel más claro.
+      */
+    byte Max() const;
+
+    /**
+      * @brief Calcula un percentil de los niveles de gris.
+      * @param percent Porcentaje de píxeles, entre 0 y 100.
+      * @pre El histograma no está vacío.
+      * @return El menor nivel v tal que al menos el @p percent % de los píxeles tiene valor menor o igual
+      * que v. Con 0 se obtiene Min() y con 100, Max().
+      */
+    byte Percentile(double percent) const;
+
+    /**
+      * @brief Media de los niveles de gris.
+      * @return El mismo valor que ImageView::Mean sobre toda la imagen (0 si está vacía).
+      */
+    double Mean() const;
+
+    /**
+      * @brief Varianza de los niveles de gris.
+      * @return La varianza poblacional de los píxeles (0 si la imagen está vacía).
+      */
+    double Variance() const;
+
+};
+
+/**
+  * @brief Calcula la tabla de consulta del ajuste automático de contraste
+  *
+  * Los niveles entre los percentiles @p low y @p high del histograma se estiran linealmente a todo el
+  * rango [0, 255]; los que quedan por debajo pasan a 0 y los que quedan por encima, a 255. Es la tabla
+  * de ContrastLUT con esos percentiles como umbrales de entrada.
+  * @param lut Tabla de 256 entradas que se rellena
+  * @param hist Histograma de la imagen
+  * @param low Percentil que pasa a ser el negro, entre 0 y 100
+  * @param high Percentil que pasa a ser el blanco, entre 0 y 100
+  * @pre @p low < @p high
+  * @post Si los dos percentiles coinciden (imagen casi uniforme) la tabla es la identidad.
+  */
+void AutoContrastLUT(byte lut[256], const ImageHistogram & hist, double low, double high);
+
+/**
+  * @brief Calcula la tabla de consulta de la ecualización del histograma
+  *
+  * Cada nivel pasa a ser proporcional al número de píxeles menores o iguales que él (histograma
+  * acumulado), de modo que el nivel más oscuro de la imagen pasa a 0, el más claro a 255 y los
+  * niveles del resultado se reparten lo más uniformemente posible.
+  * @param lut Tabla de 256 entradas que se rellena
+  * @param hist Histograma de la imagen
+  * @post Si la imagen tiene un solo nivel (o está vacía) la tabla es la identidad.
+  */
+void EqualizeLUT(byte lut[256], const ImageHistogram & hist);
+
+
+#endif // _IMAGEN_HISTOGRAMA_H_
@@ -9,6 +9,10 @@
 #ifndef _IMAGEN_ES_H_
 #define _IMAGEN_ES_H_
 
+#include <cstddef>
+#include <fstream>
+#include <string>
+
 /**
   * @brief Tipo de imagen
   *
@@ -38,11 +42,65 @@ ImageKind ReadImageKind (const char *path);
   * @return puntero a una nueva zona de memoria que contiene @a filas x @a columnas
   * bytes que corresponden a los grises de todos los píxeles
   * (desde la esquina superior izqda a la inferior drcha). En caso de que no
-  * no se pueda leer, se devuelve cero. (0).
+  * no se pueda leer, se devuelve cero. (0). También se devuelve cero, sin reservar
+  * memoria, si el archivo es más corto de lo que indica su cabecera o no hay memoria
+  * suficiente.
   * @post En caso de éxito, el puntero apunta a una zona de memoria reservada en
-  * memoria dinámica. Será el usuario el responsable de liberarla.
+  * memoria dinámica con AllocateBuffer (alineada a línea de caché). Será el
+  * usuario el responsable de liberarla con ReleaseBuffer.
+  */
+unsigned char *ReadPGMImage (const char *path, ptrdiff_t& rows, ptrdiff_t& cols);
+
+/**
+  * @brief Proyección en memoria de un archivo
+  *
+  * @see MapPGMImage
   */
-unsigned char *ReadPGMImage (const char *path, int& rows, int& cols);
+struct PGMMapping {
+  void *base;     ///< Dirección de comienzo de la proyección, o 0 si no hay proyección.
+  size_t length;  ///< Longitud en bytes de la proyección.
+};
+
+/**
+  * @brief Proyecta en memoria una imagen de tipo PGM
+  *
+  * El archivo se proyecta de forma privada (MAP_PRIVATE) con permiso de lectura y
+  * escritura: los píxeles se leen directamente de la caché de páginas del sistema,
+  * sin copiarlos, y el sistema solo duplica una página la primera vez que se escribe
+  * en ella. Las escrituras nunca llegan al archivo.
+  *
+  * @param path archivo a proyectar
+  * @param rows Parámetro de salida con las filas de la imagen.
+  * @param cols Parámetro de salida con las columnas de la imagen.
+  * @param mapping Parámetro de salida con la proyección, que debe liberarse con
+  * UnmapPGMImage.
+  * @return puntero al primer píxel dentro de la proyección, o 0 si el archivo no es
+  * un PGM válido o no puede proyectarse (en ese caso @a mapping queda vacío).
+  * @note Si otro proceso trunca el archivo mientras está proyectado, acceder a los
+  * píxeles perdidos provoca SIGBUS.
+  */
+unsigned char *MapPGMImage (const char *path, ptrdiff_t& rows, ptrdiff_t& cols, PGMMapping& mapping);
+
+/**
+  * @brief Libera una proyección creada por MapPGMImage
+  *
+  * @param mapping proyección a liberar. Queda vacía. Si ya lo estaba no hace nada.
+  */
+void UnmapPGMImage (PGMMapping& mapping);
+
+/**
+  * @brief Opciones de escritura
+  *
+  * Pueden combinarse con el operador |.
+  *
+  * @see WritePGMImage
+  */
+enum SaveMode: unsigned {
+  SAVE_DEFAULT= 0,  ///< Escribe sobre el archivo destino y deja el volcado a disco al sistema.
+  SAVE_SYNC= 1,     ///< No termina hasta que los datos (y, con SAVE_ATOMIC, el directorio) están en disco (fsync).
+  SAVE_ATOMIC= 2    ///< Escribe en un archivo temporal del mismo directorio y lo renombra al terminar:
+                    ///< el destino contiene la imagen anterior completa o la nueva completa, nunca una mezcla.
+};
 
 /**
   * @brief Escribe una imagen de tipo PGM
@@ -55,10 +113,161 @@ unsigned char *ReadPGMImage (const char *path, int& rows, int& cols);
   * @return si ha tenido éxito en la escritura.
   */
 bool WritePGMImage (const char *path, const unsigned char *datos,
-                    const int rows, const int cols);
+                    const ptrdiff_t rows, const ptrdiff_t cols);
+
+/**
+  * @brief Escribe una imagen de tipo PGM cuyas filas no están consecutivas en memoria
+  *
+  * Los píxeles se escriben directamente desde @a datos, sin copiarlos a un buffer
+  * intermedio: la cabecera y la imagen van en una única llamada a writev si las filas
+  * son consecutivas, y en llamadas a writev con un vector de filas en otro caso.
+  *
+  * @param path archivo a escribir
+  * @param datos puntero al primer píxel de la imagen de grises.
+  * @param rows filas de la imagen
+  * @param cols columnas de la imagen
+  * @param stride número de bytes entre el comienzo de dos filas consecutivas de @a datos.
+  * Puede ser negativo: las filas se recorren hacia atrás desde @a datos (vistas de FlipRows).
+  * @param mode combinación de valores de SaveMode
+  * @pre |stride| >= cols
+  * @return si ha tenido éxito en la escritura. Con SAVE_ATOMIC, si falla, el archivo
+  * destino queda como estaba.
+  * @note Sin SAVE_ATOMIC el destino se trunca antes de escribir: no debe ser el archivo
+  * del que se proyectaron (LOAD_MAP) los propios @a datos.
+  */
+bool WritePGMImage (const char *path, const unsigned char *datos,
+                    const ptrdiff_t rows, const ptrdiff_t cols, const ptrdiff_t stride,
+                    unsigned mode = SAVE_DEFAULT);
+
+
+
+
+/**
+  * @brief Lector secuencial de las filas de una imagen PGM
+  *
+  * Permite recorrer una imagen de tipo P5 de arriba abajo sin cargarla entera: solo
+  * se mantiene en memoria el buffer del flujo y las filas que pida el usuario.
+  *
+  * @see PGMRowSink
+  */
+class PGMRowSource {
+
+  private:
+
+    std::ifstream file;   ///< Flujo del archivo, situado al comienzo de la siguiente fila.
+    ptrdiff_t rows;       ///< Filas de la imagen.
+    ptrdiff_t cols;       ///< Columnas de la imagen.
+    ptrdiff_t next_row;   ///< Índice de la siguiente fila a leer.
+
+  public:
+
+    /**
+      * @brief Constructor por defecto. El lector queda cerrado.
+      */
+    PGMRowSource ();
+
+    /**
+      * @brief Abre una imagen PGM y lee su cabecera
+      *
+      * @param path archivo a leer
+      * @return si el archivo existe y es una imagen PGM válida.
+      */
+    bool Open (const char *path);
+
+    /**
+      * @brief Filas de la imagen abierta
+      */
+    ptrdiff_t get_rows () const;
+
+    /**
+      * @brief Columnas de la imagen abierta
+      */
+    ptrdiff_t get_cols () const;
+
+    /**
+      * @brief Número de filas que quedan por leer
+      */
+    ptrdiff_t remaining_rows () const;
+
+    /**
+      * @brief Lee las siguientes filas de la imagen
+      *
+      * @param buffer destino de @a count x get_cols() bytes, fila tras fila.
+      * @param count número de filas a leer
+      * @pre @a count <= remaining_rows()
+      * @return si la lectura ha tenido éxito.
+      */
+    bool ReadRows (unsigned char *buffer, ptrdiff_t count = 1);
+};
+
+/**
+  * @brief Escritor secuencial de las filas de una imagen PGM
+  *
+  * Escribe la cabecera de una imagen de tipo P5 al abrirse y, a continuación, las
+  * filas que se le van entregando en orden.
+  *
+  * @see PGMRowSource
+  */
+class PGMRowSink {
+
+  private:
+
+    std::ofstream file;       ///< Flujo del archivo.
+    ptrdiff_t rows;           ///< Filas de la imagen.
+    ptrdiff_t cols;           ///< Columnas de la imagen.
+    ptrdiff_t written;        ///< Filas escritas hasta el momento.
+    unsigned mode;            ///< Combinación de valores de SaveMode.
+    std::string target;       ///< Archivo destino.
+    std::string temporary;    ///< Archivo temporal con SAVE_ATOMIC, vacío si no hay.
+
+    PGMRowSink (const PGMRowSink&);              // No se puede copiar
+    PGMRowSink& operator= (const PGMRowSink&);
+
+  public:
+
+    /**
+      * @brief Constructor por defecto. El escritor queda cerrado.
+      */
+    PGMRowSink ();
+
+    /**
+      * @brief Destructor. Con SAVE_ATOMIC, si no se llegó a cerrar con éxito, borra el
+      * archivo temporal y el destino queda como estaba.
+      */
+    ~PGMRowSink ();
 
+    /**
+      * @brief Crea el archivo y escribe la cabecera
+      *
+      * @param path archivo a escribir
+      * @param nrows filas de la imagen
+      * @param ncols columnas de la imagen
+      * @param nmode combinación de valores de SaveMode. Con SAVE_ATOMIC las filas se escriben
+      * en un archivo temporal que sustituye al destino en Close, de modo que el destino puede
+      * ser el archivo del que se están leyendo (o del que se proyectaron) los datos.
+      * @return si ha tenido éxito.
+      */
+    bool Open (const char *path, ptrdiff_t nrows, ptrdiff_t ncols, unsigned nmode = SAVE_DEFAULT);
 
+    /**
+      * @brief Escribe las siguientes filas de la imagen
+      *
+      * @param buffer origen de @a count x ncols bytes, fila tras fila.
+      * @param count número de filas a escribir
+      * @return si la escritura ha tenido éxito y no se han superado las filas
+      * indicadas en Open.
+      */
+    bool WriteRows (const unsigned char *buffer, ptrdiff_t count = 1);
 
+    /**
+      * @brief Cierra el archivo
+      *
+      * Con SAVE_ATOMIC renombra el temporal al destino si todo ha ido bien y lo borra en
+      * otro caso.
+      * @return si se han escrito todas las filas y el archivo se ha cerrado sin errores.
+      */
+    bool Close ();
+};
 
 #endif
 
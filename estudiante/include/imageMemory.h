@@ -0,0 +1,162 @@
+/**
+  * @file imageMemory.h
+  * @brief Fichero cabecera para la gestión de la memoria de los píxeles
+  *
+  * Centraliza la reserva y liberación de los buffers de píxeles de las imágenes y de las
+  * memorias intermedias que contienen píxeles o sumas de píxeles: la imagen integral, los
+  * bloques de ImagePipeline, las filas de las reducciones y de Resample y los buffers de la
+  * traza. Las tablas auxiliares pequeñas (pesos de interpolación, permutaciones, vectores
+  * de filas para writev) se reservan aparte y no figuran en los contadores.
+  *
+  */
+
+#ifndef _IMAGEN_MEMORIA_H_
+#define _IMAGEN_MEMORIA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+/**
+  * @brief Alineamiento (en bytes) de los buffers de píxeles.
+  *
+  * Coincide con el tamaño de una línea de caché, de forma que la primera fila
+  * de una imagen nunca queda repartida entre dos líneas.
+  */
+const size_t CACHE_LINE_SIZE = 64;
+
+/**
+  * @brief Contadores de reservas de buffers de píxeles.
+  *
+  * Acumulan todas las llamadas a AllocateBuffer y ReleaseBuffer desde el inicio del programa.
+  * Restando dos consultas se obtiene el coste de un fragmento de código. Las imágenes cargadas
+  * con LOAD_MAP proyectan el fichero y no reservan buffer, por lo que no aparecen aquí.
+  */
+struct AllocationStats {
+    size_t allocations;   ///< Número de buffers reservados.
+    size_t releases;      ///< Número de buffers liberados.
+    size_t bytes;         ///< Bytes reservados en total.
+    size_t current;       ///< Bytes de los buffers reservados y aún no liberados.
+    size_t peak;          ///< Máximo de current desde el inicio o desde el último ResetPeakAllocation.
+};
+
+/**
+  * @brief Contadores de las reservas hechas desde un punto del código.
+  */
+struct AllocationSite {
+    const char * site;    ///< Nombre del punto de reserva.
+    size_t allocations;   ///< Número de buffers reservados.
+    size_t releases;      ///< Número de buffers liberados.
+    size_t bytes;         ///< Bytes reservados en total.
+    size_t current;       ///< Bytes de los buffers reservados y aún no liberados.
+};
+
+/**
+  * @brief Reserva un buffer contiguo de bytes alineado a línea de caché.
+  *
+  * @param bytes Número de bytes a reservar.
+  * @param site Nombre del punto de reserva, para GetAllocationSites. No se copia: debe ser un
+  * literal.
+  * @return Puntero al buffer reservado, o 0 si @p bytes es 0.
+  * @post El buffer debe liberarse con ReleaseBuffer.
+  * @exception std::bad_alloc si no hay memoria suficiente.
+  */
+unsigned char *AllocateBuffer (size_t bytes, const char *site = "sin nombre");
+
+/**
+  * @brief Libera un buffer reservado con AllocateBuffer.
+  *
+  * @param buffer Puntero al buffer. Si es 0 no hace nada.
+  */
+void ReleaseBuffer (unsigned char *buffer);
+
+/**
+  * @brief Reserva de memoria para contenedores de la biblioteca estándar con AllocateBuffer.
+  *
+  * Permite que las memorias intermedias guardadas en un std::vector figuren en los contadores
+  * con su propio punto de reserva:
+  * @code
+  *   std::vector<unsigned char, BufferAllocator<unsigned char>> temp(n, 0, BufferAllocator<unsigned char>("Resample"));
+  * @endcode
+  * Todas las instancias son intercambiables: ReleaseBuffer no depende del punto de reserva.
+  */
+template <class T>
+class BufferAllocator {
+
+  public:
+
+    typedef T value_type;
+
+    const char * site;    ///< Nombre del punto de reserva. Debe ser un literal.
+
+    /**
+      * @brief Constructor
+      * @param name nombre del punto de reserva (literal)
+      */
+    explicit BufferAllocator (const char * name = "sin nombre") : site(name){}
+
+    /**
+      * @brief Constructor a partir de la reserva de otro tipo, con el mismo punto de reserva
+      */
+    template <class U>
+    BufferAllocator (const BufferAllocator<U> & other) : site(other.site){}
+
+    /**
+      * @brief Reserva espacio para @p n objetos
+      * @exception std::bad_alloc si no hay memoria suficiente.
+      */
+    T * allocate (size_t n){
+      if (n > SIZE_MAX / sizeof(T))
+        throw std::bad_alloc();
+      return reinterpret_cast<T *>(AllocateBuffer(n * sizeof(T), site));
+    }
+
+    /**
+      * @brief Libera el espacio reservado con allocate
+      */
+    void deallocate (T * p, size_t){
+      ReleaseBuffer(reinterpret_cast<unsigned char *>(p));
+    }
+};
+
+template <class T, class U>
+bool operator== (const BufferAllocator<T> &, const BufferAllocator<U> &){ return true; }
+
+template <class T, class U>
+bool operator!= (const BufferAllocator<T> &, const BufferAllocator<U> &){ return false; }
+
+/**
+  * @brief Consulta los contadores de reservas.
+  *
+  * @return Los contadores acumulados hasta el momento.
+  */
+AllocationStats GetAllocationStats ();
+
+/**
+  * @brief Reinicia el pico de memoria
+  *
+  * Tras llamarla, el campo peak de GetAllocationStats vale los bytes reservados en ese
+  * momento, de modo que una consulta posterior da el pico de un fragmento de código.
+  */
+void ResetPeakAllocation ();
+
+/**
+  * @brief Consulta los contadores de cada punto de reserva.
+  *
+  * @return Un elemento por cada nombre pasado a AllocateBuffer, en el orden de su primera reserva.
+  */
+std::vector<AllocationSite> GetAllocationSites ();
+
+/**
+  * @brief Muestra en la salida de error los contadores y los buffers pendientes de liberar.
+  *
+  * Si la variable de entorno IMAGE_MEMORY_REPORT está definida, se llama automáticamente al
+  * terminar el programa: los bytes que aún figuren como reservados son buffers perdidos, salvo
+  * los del punto "Traza", que se conservan hasta el final para guardar la traza.
+  */
+void PrintAllocationReport ();
+
+#endif
+
+/* Fin Fichero: imageMemory.h */
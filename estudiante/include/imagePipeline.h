@@ -0,0 +1,223 @@
+/**
+ * @file imagePipeline.h
+ * @brief Cabecera para la clase ImagePipeline
+ */
+
+#ifndef _IMAGEN_CADENA_H_
+#define _IMAGEN_CADENA_H_
+
+#include <vector>
+#include "imageMemory.h"
+#include "imageView.h"
+
+
+/**
+  @brief T.D.A. Cadena diferida de operaciones sobre una imagen
+
+  Una instancia de ImagePipeline registra una secuencia de operaciones (recortes, operaciones puntuales,
+  reducciones y ampliaciones) sobre una imagen de origen sin calcular nada. Al pedir el resultado (Run o
+  Save) todas las operaciones se ejecutan en una sola pasada por bloques de pocas filas: cada bloque del
+  resultado se calcula pidiendo a la operación anterior solo las filas que necesita, de modo que las
+  imágenes intermedias nunca existen completas y cada bloque se mantiene en la caché entre una operación
+  y la siguiente. Los bloques se reparten entre hilos igual que las operaciones de Image.
+
+  Además, al registrar las operaciones:
+  - Las operaciones puntuales consecutivas se combinan en una única tabla de consulta.
+  - Los recortes previos a cualquier reducción o ampliación se aplican directamente a la vista de origen
+    (no cuestan nada).
+
+  El resultado es idéntico, píxel a píxel, al de encadenar las operaciones equivalentes de Image.
+
+  La cadena no copia la imagen de origen: solo es válida mientras lo sea la imagen de la que procede la
+  vista.
+
+  Un ejemplo de su uso:
+  @code
+    ImagePipeline pipeline(image.View());
+    pipeline.Crop(10, 10, 200, 200).Invert().Zoom2X();
+    Image result = pipeline.Run();
+  @endcode
+
+**/
+
+class ImagePipeline{
+
+private :
+
+    /**
+      @brief Operaciones que puede registrar la cadena.
+    **/
+    enum StageKind {STAGE_LUT, STAGE_CROP, STAGE_SUBSAMPLE, STAGE_ZOOM};
+
+    /**
+      @brief Operación registrada y dimensiones de su resultado.
+    **/
+    struct Stage {
+        StageKind kind;
+        ptrdiff_t row, col;     ///< Esquina del recorte (STAGE_CROP)
+        ptrdiff_t factor;       ///< Factor de reducción (STAGE_SUBSAMPLE)
+        byte lut[256];          ///< Tabla de consulta (STAGE_LUT)
+        ptrdiff_t rows, cols;   ///< Dimensiones del resultado de la operación
+    };
+
+    /**
+      @brief Vista de origen, con los recortes iniciales ya aplicados.
+    **/
+    ImageView source;
+
+    /**
+      @brief Operaciones registradas, en orden de aplicación.
+    **/
+    std::vector<Stage> stages;
+
+    /**
+      @brief Dimensiones del resultado de la cadena.
+    **/
+    ptrdiff_t rows, cols;
+
+    /**
+      @brief Añade una operación puntual, combinándola con la anterior si también lo es.
+      @param lut Tabla de 256 entradas de la operación.
+    **/
+    void PushLUT(const byte lut[256]);
+
+    /**
+      @brief Descarta todas las operaciones: el resultado pasa a ser una imagen vacía.
+    **/
+    void MakeEmpty();
+
+    /**
+      @brief Filas del resultado que se calculan en cada bloque.
+      @return Número de filas tal que el bloque más grande de la cadena ocupe unos 64KB.
+    **/
+    ptrdiff_t TileRows() const;
+
+    /**
+      @brief Calcula un bloque de filas del resultado de una operación.
+      @param k Número de operaciones aplicadas (0 = vista de origen).
+      @param begin Primera fila del bloque.
+      @param end Fila siguiente a la última del bloque.
+      @param scratch Memoria intermedia de cada operación, propia del hilo que llama. Se reserva con
+      AllocateBuffer, en el punto de reserva "ImagePipeline".
+      @param target Si no es nulo, las filas se escriben allí (separadas @p target_stride bytes) en lugar
+      de en la memoria intermedia.
+      @param target_stride Separación entre filas de @p target.
+      @return Vista de las filas calculadas. Puede apuntar a la imagen de origen, a @p scratch o a
+      @p target.
+    **/
+    ImageView Produce(size_t k, ptrdiff_t begin, ptrdiff_t end,
+                      std::vector<std::vector<byte, BufferAllocator<byte>>> & scratch,
+                      byte * target = 0, ptrdiff_t target_stride = 0) const;
+
+    /**
+      @brief Calcula unas filas consecutivas del resultado, repartidas entre hilos.
+      @param first Primera fila del resultado que se calcula.
+      @param dst Vista de destino: se calculan las filas [first, first + dst.get_rows()).
+    **/
+    void RunRows(ptrdiff_t first, const MutableImageView & dst) const;
+
+public :
+
+    /**
+      * @brief Constructor por defecto.
+      * @post Genera una cadena sin origen, cuyo resultado es una imagen vacía.
+      */
+    ImagePipeline();
+
+    /**
+      * @brief Construye una cadena sin operaciones sobre una imagen.
+      * @param view Imagen (o región) de origen.
+      */
+    explicit ImagePipeline(const ImageView & view);
+
+    /**
+      * @brief Filas del resultado.
+      * @return El número de filas que tendrá la imagen resultado.
+      */
+    ptrdiff_t get_rows() const;
+
+    /**
+      * @brief Columnas del resultado.
+      * @return El número de columnas que tendrá la imagen resultado.
+      */
+    ptrdiff_t get_cols() const;
+
+    /**
+      * @brief Comprueba si el resultado es una imagen vacía.
+      * @return true si el resultado tiene 0 filas o 0 columnas.
+      */
+    bool Empty() const;
+
+    /**
+     * @brief Registra un recorte
+     * @see ImageView::Crop
+     * @return La propia cadena, para encadenar más operaciones.
+     */
+    ImagePipeline & Crop(ptrdiff_t nrow, ptrdiff_t ncol, ptrdiff_t height, ptrdiff_t width);
+
+    /**
+     * @brief Registra una operación puntual con una tabla de consulta
+     * @see Image::ApplyLUT
+     * @return La propia cadena, para encadenar más operaciones.
+     */
+    ImagePipeline & ApplyLUT(const byte lut[256]);
+
+    /**
+     * @brief Registra el negativo
+     * @see Image::Invert
+     * @return La propia cadena, para encadenar más operaciones.
+     */
+    ImagePipeline & Invert();
+
+    /**
+     * @brief Registra un ajuste de contraste
+     * @see Image::AdjustContrast
+     * @return La propia cadena, para encadenar más operaciones.
+     */
+    ImagePipeline & AdjustContrast(byte in1, byte in2, byte out1, byte out2);
+
+    /**
+     * @brief Registra una reducción promediando bloques
+     * @see Image::Subsample
+     * @pre @p factor > 0
+     * @return La propia cadena, para encadenar más operaciones.
+     */
+    ImagePipeline & Subsample(ptrdiff_t factor);
+
+    /**
+     * @brief Registra una ampliación al doble de tamaño
+     * @see Image::Zoom2X
+     * @return La propia cadena, para encadenar más operaciones.
+     */
+    ImagePipeline & Zoom2X();
+
+    /**
+     * @brief Ejecuta la cadena
+     * @return Imagen resultado de aplicar todas las operaciones registradas a la imagen de origen.
+     */
+    Image Run() const;
+
+    /**
+     * @brief Ejecuta la cadena escribiendo el resultado en una vista
+     * @param dst Vista de destino.
+     * @pre @p dst tiene get_rows() filas y get_cols() columnas, y no se solapa con la imagen de origen.
+     */
+    void Run(const MutableImageView & dst) const;
+
+    /**
+     * @brief Ejecuta la cadena y guarda el resultado en un fichero PGM
+     *
+     * El resultado se escribe por grupos de bloques a medida que se calcula (ver PGMRowSink), sin
+     * construir la imagen resultado completa.
+     * Se escribe en un archivo temporal que sustituye al destino al terminar (SAVE_ATOMIC), de modo
+     * que el destino puede ser el archivo del que procede la imagen de origen, aunque esté proyectado
+     * en memoria. Si falla, el destino queda como estaba.
+     * @param file_path Ruta del fichero.
+     * @return true si el fichero se ha escrito correctamente.
+     */
+    bool Save(const char * file_path) const;
+
+};
+
+
+#endif // _IMAGEN_CADENA_H_
@@ -0,0 +1,72 @@
+/**
+  * @file imageScale.h
+  * @brief Fichero cabecera para los núcleos de cambio de tamaño de imágenes
+  *
+  * Núcleos que trabajan directamente sobre vistas, sin imágenes intermedias. Los usan
+  * ImageView e Image para implementar sus operaciones de cambio de tamaño.
+  *
+  */
+
+#ifndef _IMAGEN_ESCALA_H_
+#define _IMAGEN_ESCALA_H_
+
+#include <cstddef>
+
+class ImageView;
+class MutableImageView;
+
+/**
+  * @brief Filtro de interpolación de Resize
+  *
+  * Ordenados de menor a mayor calidad y coste: el número de píxeles que se combinan
+  * por cada píxel de salida (en cada dirección) es 2, 4 y 6 al ampliar, y crece en
+  * proporción al factor al reducir.
+  */
+enum ResizeFilter: unsigned char {
+  RESIZE_BILINEAR,  ///< Interpolación lineal (filtro triangular).
+  RESIZE_BICUBIC,   ///< Interpolación cúbica de Keys (a = -0.5).
+  RESIZE_LANCZOS3   ///< Filtro de Lanczos de 3 lóbulos.
+};
+
+/**
+  * @brief Reduce una vista promediando bloques de @a factor x @a factor píxeles
+  *
+  * Las filas de cada bloque se suman columna a columna con AccumulateRow y después se
+  * suman los @a factor contadores de cada bloque. Los factores 2, 4 y 8 tienen versiones
+  * específicas en las que la división es un desplazamiento.
+  *
+  * El píxel (i, j) de @a dst vale lround(media) del bloque que empieza en
+  * (i*factor, j*factor), calculado con aritmética entera exacta.
+  *
+  * @param src vista de origen
+  * @param dst vista de destino
+  * @param factor lado de los bloques
+  * @pre @a factor > 0, dst.get_rows() * @a factor <= src.get_rows() y
+  * dst.get_cols() * @a factor <= src.get_cols()
+  * @see ImageView::Subsample
+  */
+void BoxDownsample (const ImageView& src, const MutableImageView& dst, ptrdiff_t factor);
+
+/**
+  * @brief Cambia el tamaño de una vista a unas dimensiones cualesquiera
+  *
+  * Para cada columna y cada fila de la salida se calculan una sola vez los píxeles de
+  * la entrada que intervienen y sus pesos (en punto fijo, ver RESAMPLE_BITS). Después se
+  * hacen dos pasadas separables, repartidas por bandas entre hilos: la horizontal
+  * (ResampleRow) deja una imagen intermedia de src.get_rows() x dst.get_cols(), y la
+  * vertical (BlendRows) combina sus filas.
+  *
+  * Al reducir, el filtro se ensancha en proporción al factor, de modo que cada píxel
+  * promedia toda la región que representa. En los bordes los pesos se reparten entre los
+  * píxeles existentes.
+  *
+  * @param src vista de origen, no vacía
+  * @param dst vista de destino, no vacía
+  * @param filter filtro de interpolación
+  * @see ImageView::Resize
+  */
+void Resample (const ImageView& src, const MutableImageView& dst, ResizeFilter filter);
+
+#endif
+
+/* Fin Fichero: imageScale.h */
@@ -0,0 +1,185 @@
+/**
+  * @file imageSimd.h
+  * @brief Fichero cabecera para los núcleos vectorizados de procesamiento de filas
+  *
+  * Los núcleos trabajan sobre tramos contiguos de bytes (una fila, o la imagen completa
+  * si sus filas son consecutivas). La implementación concreta (escalar, SSE2, AVX2 o
+  * AVX-512) se elige en tiempo de ejecución según el procesador.
+  *
+  */
+
+#ifndef _IMAGEN_SIMD_H_
+#define _IMAGEN_SIMD_H_
+
+#include <cstddef>
+
+/**
+  * @brief Juego de instrucciones vectoriales
+  *
+  * Los niveles están ordenados: cada uno incluye a los anteriores.
+  *
+  * @see DetectSimdLevel
+  */
+enum SimdLevel {SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512};
+
+/**
+  * @brief Devuelve el mejor nivel soportado por el procesador
+  *
+  * @return SIMD_SCALAR en arquitecturas distintas de x86 o si el compilador no
+  * permite generar código vectorial específico.
+  */
+SimdLevel DetectSimdLevel ();
+
+/**
+  * @brief Devuelve el nivel con el que se ejecutan los núcleos
+  *
+  * Por defecto es el de DetectSimdLevel.
+  */
+SimdLevel GetSimdLevel ();
+
+/**
+  * @brief Fuerza el nivel con el que se ejecutan los núcleos
+  *
+  * Pensado para comparar implementaciones (pruebas de eficiencia y de corrección).
+  * No debe llamarse mientras otro hilo esté ejecutando un núcleo.
+  *
+  * @param level nivel deseado
+  * @return nivel realmente aplicado: @a level, limitado al que soporta el procesador.
+  */
+SimdLevel SetSimdLevel (SimdLevel level);
+
+/**
+  * @brief Nombre legible de un nivel
+  *
+  * @param level nivel
+  * @return "scalar", "sse2", "avx2" o "avx512"
+  */
+const char *SimdLevelName (SimdLevel level);
+
+/**
+  * @brief Invierte un tramo de píxeles: dst[k] = 255 - src[k]
+  *
+  * @param dst destino de @a n bytes
+  * @param src origen de @a n bytes. Puede coincidir con @a dst.
+  * @param n número de bytes
+  */
+void InvertRow (unsigned char *dst, const unsigned char *src, size_t n);
+
+/**
+  * @brief Aplica una tabla de consulta a un tramo de píxeles: dst[k] = lut[src[k]]
+  *
+  * Con AVX-512 VBMI la tabla se consulta con vpermi2b. En el resto de casos se usa
+  * la versión escalar.
+  *
+  * @param dst destino de @a n bytes
+  * @param src origen de @a n bytes. Puede coincidir con @a dst.
+  * @param n número de bytes
+  * @param lut tabla de 256 entradas
+  */
+void ApplyLUTRow (unsigned char *dst, const unsigned char *src, size_t n,
+                  const unsigned char *lut);
+
+/**
+  * @brief Acumula un tramo de píxeles en contadores de 16 bits: acc[k] += src[k]
+  *
+  * Sirve para sumar columnas de varias filas (por ejemplo, los bloques de Subsample).
+  * Sin desbordamiento caben las sumas de hasta 257 filas.
+  *
+  * @param acc contadores de @a n posiciones
+  * @param src origen de @a n bytes
+  * @param n número de bytes
+  */
+void AccumulateRow (unsigned short *acc, const unsigned char *src, size_t n);
+
+/**
+  * @brief Fila par de Zoom2X: los píxeles de @a src intercalados con sus medias
+  *
+  * dst[2j] = src[j] y dst[2j+1] = (src[j] + src[j+1] + 1) / 2, que es el redondeo de
+  * la media que da lround. Con SSE2 y AVX2 la media se calcula con pavgb.
+  *
+  * @param dst destino de 2 @a n - 1 bytes
+  * @param src fila de @a n bytes
+  * @param n número de píxeles de la fila, @a n > 0
+  */
+void ZoomEvenRow (unsigned char *dst, const unsigned char *src, size_t n);
+
+/**
+  * @brief Fila impar de Zoom2X: medias de dos filas intercaladas con medias de 2x2
+  *
+  * dst[2j] = (a[j] + b[j] + 1) / 2 y dst[2j+1] = (a[j] + a[j+1] + b[j] + b[j+1] + 2) / 4.
+  * La media de cuatro se calcula en 16 bits, ya que dos pavgb encadenados no redondean
+  * igual.
+  *
+  * @param dst destino de 2 @a n - 1 bytes
+  * @param a fila superior de @a n bytes
+  * @param b fila inferior de @a n bytes
+  * @param n número de píxeles de cada fila, @a n > 0
+  */
+void ZoomOddRow (unsigned char *dst, const unsigned char *a, const unsigned char *b, size_t n);
+
+/**
+  * @brief Bits de la parte fraccionaria de los pesos de ResampleRow y BlendRows
+  *
+  * Un peso p representa p / 2^RESAMPLE_BITS; los pesos de un píxel suman 2^RESAMPLE_BITS.
+  */
+const int RESAMPLE_BITS = 14;
+
+/**
+  * @brief Pasada horizontal de un remuestreo: cada píxel de salida combina un tramo de la fila
+  *
+  * dst[j] = sum(weights[j*taps + k] * src[first[j] + k], k < taps) / 2^RESAMPLE_BITS,
+  * redondeado y limitado a [0, 255]. Con SSE2 los productos se hacen de 8 en 8 con pmaddwd.
+  *
+  * @param dst destino de @a n bytes
+  * @param src fila de origen
+  * @param n número de píxeles de salida
+  * @param first primer píxel de @a src de cada píxel de salida
+  * @param weights @a taps pesos por píxel de salida
+  * @param taps píxeles de @a src por píxel de salida
+  */
+void ResampleRow (unsigned char *dst, const unsigned char *src, size_t n,
+                  const ptrdiff_t *first, const short *weights, size_t taps);
+
+/**
+  * @brief Pasada vertical de un remuestreo: combina varias filas con un peso por fila
+  *
+  * dst[j] = sum(weights[k] * rows[k][j], k < taps) / 2^RESAMPLE_BITS, redondeado y
+  * limitado a [0, 255]. Las versiones vectoriales procesan las filas de dos en dos con
+  * pmaddwd.
+  *
+  * @param dst destino de @a n bytes
+  * @param rows @a taps filas de al menos @a n bytes
+  * @param weights peso de cada fila
+  * @param taps número de filas
+  * @param n número de píxeles
+  */
+void BlendRows (unsigned char *dst, const unsigned char *const *rows, const short *weights,
+                size_t taps, size_t n);
+
+/**
+  * @brief Traspone un bloque de 16 x 16 píxeles: dst[j][i] = src[i][j]
+  *
+  * Con SSE2 las 16 filas se trasponen en registros con cuatro etapas de unpack (bytes,
+  * palabras, dobles palabras y cuádruples palabras).
+  *
+  * @param dst primer píxel del bloque de destino
+  * @param dst_stride bytes entre filas consecutivas de @a dst (puede ser negativo)
+  * @param src primer píxel del bloque de origen
+  * @param src_stride bytes entre filas consecutivas de @a src (puede ser negativo)
+  * @pre Los bloques no se solapan.
+  */
+void TransposeBlock16 (unsigned char *dst, ptrdiff_t dst_stride,
+                       const unsigned char *src, ptrdiff_t src_stride);
+
+/**
+  * @brief Invierte el orden de un tramo de píxeles: dst[k] = src[n-1-k]
+  *
+  * @param dst destino de @a n bytes
+  * @param src origen de @a n bytes. No puede solaparse con @a dst.
+  * @param n número de bytes
+  */
+void ReverseRow (unsigned char *dst, const unsigned char *src, size_t n);
+
+#endif
+
+/* Fin Fichero: imageSimd.h */
@@ -0,0 +1,114 @@
+/**
+  * @file imageStream.h
+  * @brief Fichero cabecera para el procesamiento de imágenes PGM por filas
+  *
+  * Operaciones que leen una imagen de disco y escriben el resultado fila a fila con
+  * PGMRowSource y PGMRowSink, sin cargar nunca la imagen completa. La memoria usada
+  * depende del ancho de la imagen (unas pocas filas), no de su altura, de modo que
+  * pueden procesarse imágenes mayores que la memoria disponible.
+  *
+  * El resultado es idéntico, píxel a píxel, al de la operación equivalente de Image.
+  *
+  * El resultado se escribe en un archivo temporal que sustituye a la salida al terminar, de
+  * modo que la salida puede ser el propio archivo de entrada.
+  *
+  */
+
+#ifndef _IMAGEN_FLUJO_H_
+#define _IMAGEN_FLUJO_H_
+
+#include <cstddef>
+
+/**
+  * @brief Aplica una tabla de consulta a una imagen PGM
+  *
+  * @param input archivo de entrada
+  * @param output archivo de salida
+  * @param lut tabla de 256 entradas: el píxel de valor v pasa a valer lut[v]
+  * @return si la lectura y la escritura han tenido éxito.
+  * @see Image::ApplyLUT
+  */
+bool StreamApplyLUT (const char *input, const char *output, const unsigned char lut[256]);
+
+/**
+  * @brief Calcula el negativo de una imagen PGM
+  *
+  * @param input archivo de entrada
+  * @param output archivo de salida
+  * @return si la lectura y la escritura han tenido éxito.
+  * @see Image::Invert
+  */
+bool StreamInvert (const char *input, const char *output);
+
+/**
+  * @brief Ajusta el contraste de una imagen PGM
+  *
+  * @param input archivo de entrada
+  * @param output archivo de salida
+  * @param in1 Umbral inferior de la image de entrada
+  * @param in2 Umbral superior de la imagen de entrada
+  * @param out1 Umbral inferior de la imagen de salida
+  * @param out2 Umbral superior de la imagen de la salida
+  * @return si la lectura y la escritura han tenido éxito.
+  * @see Image::AdjustContrast
+  */
+bool StreamAdjustContrast (const char *input, const char *output,
+                           unsigned char in1, unsigned char in2,
+                           unsigned char out1, unsigned char out2);
+
+/**
+  * @brief Ajusta el contraste de una imagen PGM a partir de su histograma
+  *
+  * El archivo de entrada se lee dos veces: la primera para calcular el histograma y la
+  * segunda para aplicar la tabla del ajuste.
+  *
+  * @param input archivo de entrada
+  * @param output archivo de salida
+  * @param low Percentil que pasa a ser el negro, entre 0 y 100
+  * @param high Percentil que pasa a ser el blanco, entre 0 y 100
+  * @return si la lectura y la escritura han tenido éxito.
+  * @see Image::AutoContrast
+  */
+bool StreamAutoContrast (const char *input, const char *output, double low, double high);
+
+/**
+  * @brief Ecualiza el histograma de una imagen PGM
+  *
+  * Como StreamAutoContrast, lee el archivo de entrada dos veces.
+  *
+  * @param input archivo de entrada
+  * @param output archivo de salida
+  * @return si la lectura y la escritura han tenido éxito.
+  * @see Image::Equalize
+  */
+bool StreamEqualize (const char *input, const char *output);
+
+/**
+  * @brief Reduce una imagen PGM promediando bloques
+  *
+  * Solo se mantienen en memoria las sumas de una fila de bloques.
+  *
+  * @param input archivo de entrada
+  * @param output archivo de salida
+  * @param factor valor de reducción
+  * @pre @a factor > 0
+  * @return si la lectura y la escritura han tenido éxito.
+  * @see Image::Subsample
+  */
+bool StreamSubsample (const char *input, const char *output, ptrdiff_t factor);
+
+/**
+  * @brief Aumenta una imagen PGM al doble de tamaño
+  *
+  * Solo se mantienen en memoria dos filas de la entrada y una de la salida.
+  *
+  * @param input archivo de entrada
+  * @param output archivo de salida
+  * @return si la lectura y la escritura han tenido éxito.
+  * @see Image::Zoom2X
+  */
+bool StreamZoom2X (const char *input, const char *output);
+
+#endif
+
+/* Fin Fichero: imageStream.h */
@@ -0,0 +1,72 @@
+/**
+  * @file imageThreads.h
+  * @brief Fichero cabecera para el reparto de operaciones entre hilos
+  *
+  * Las operaciones de Image dividen la imagen en bandas de filas consecutivas y las
+  * reparten entre los hilos de un conjunto interno, creado la primera vez que se usa.
+  * Cada banda escribe una parte distinta del resultado y se calcula igual la procese
+  * el hilo que la procese, de modo que el resultado no depende del número de hilos.
+  *
+  */
+
+#ifndef _IMAGEN_HILOS_H_
+#define _IMAGEN_HILOS_H_
+
+#include <cstddef>
+#include <functional>
+
+/**
+  * @brief Número de hilos con el que se ejecutan las operaciones
+  *
+  * Por defecto es el valor de la variable de entorno IMAGE_THREADS o, si no está
+  * definida (o no es un entero positivo), el número de núcleos del sistema.
+  *
+  * @return número de hilos, incluido el que llama (1 = ejecución secuencial).
+  */
+int GetThreadCount ();
+
+/**
+  * @brief Fija el número de hilos con el que se ejecutan las operaciones
+  *
+  * No debe llamarse mientras otro hilo esté ejecutando una operación.
+  *
+  * @param count número de hilos. Con 0 se vuelve al valor por defecto.
+  * @return número de hilos realmente aplicado.
+  * @see GetThreadCount
+  */
+int SetThreadCount (int count);
+
+/**
+  * @brief Ejecuta un bucle repartiendo sus iteraciones en bandas entre los hilos
+  *
+  * El intervalo [0, @a count) se divide en bandas consecutivas de al menos @a grain
+  * iteraciones y se llama a @a body(begin, end) una vez por banda. El hilo que llama
+  * también procesa bandas, y la función no termina hasta que todas han terminado.
+  *
+  * Si ya hay otro ParallelFor en marcha (por ejemplo, se llama desde dentro de
+  * @a body) el bucle se ejecuta entero en el hilo que llama.
+  *
+  * @param count número de iteraciones
+  * @param grain número mínimo de iteraciones por banda, para que el reparto compense
+  * @param body función que procesa las iteraciones [begin, end). Las bandas deben
+  * escribir en zonas de memoria distintas. Si alguna lanza una excepción, las bandas que no
+  * han empezado no se ejecutan y, cuando terminan las que están en curso, la primera
+  * excepción se relanza en el hilo que llamó a ParallelFor.
+  */
+void ParallelFor (ptrdiff_t count, ptrdiff_t grain,
+                  const std::function<void (ptrdiff_t, ptrdiff_t)>& body);
+
+/**
+  * @brief Número mínimo de filas por banda para procesar imágenes de una anchura
+  *
+  * Cada banda procesa al menos unos 64KB, de modo que las imágenes pequeñas se
+  * procesan en un solo hilo.
+  *
+  * @param cols bytes por fila
+  * @return filas por banda, al menos 1.
+  */
+ptrdiff_t RowGrain (ptrdiff_t cols);
+
+#endif
+
+/* Fin Fichero: imageThreads.h */
@@ -0,0 +1,129 @@
+/**
+  * @file imageTrace.h
+  * @brief Fichero cabecera para la traza de ejecución de las operaciones
+  *
+  * Las operaciones de Image, la E/S y las bandas de ParallelFor marcan su inicio y su fin
+  * con IMAGE_TRACE_SCOPE. Si la variable de entorno IMAGE_TRACE contiene una ruta, cada
+  * marca se guarda como un intervalo en un buffer circular propio del hilo que la ejecuta
+  * (sin cerrojos ni reservas de memoria tras el primer intervalo del hilo) y al terminar el
+  * programa se escriben todos en esa ruta en el formato JSON de trazas de Chrome, que
+  * abren chrome://tracing y https://ui.perfetto.dev:
+  * @code
+  *   IMAGE_TRACE=zoom.json ./zoom vacas.pgm salida.pgm 10 10 200 200
+  * @endcode
+  *
+  * Sin la variable, cada marca cuesta una lectura de un indicador y un salto, en línea en el
+  * punto de la marca: unos pocos nanosegundos, despreciables frente a cualquier operación
+  * que recorra la imagen. Compilando con IMAGE_NO_TRACE las marcas desaparecen por completo.
+  *
+  */
+
+#ifndef _IMAGEN_TRAZA_H_
+#define _IMAGEN_TRAZA_H_
+
+#include <atomic>
+
+/**
+  * @brief Eventos que guarda cada hilo. Al superarse se conservan los más recientes.
+  */
+const unsigned TRACE_EVENTS_PER_THREAD = 1 << 15;
+
+/**
+  * @brief Estado de la traza: -1 sin consultar IMAGE_TRACE todavía, 0 inactiva, 1 activa
+  * @note Uso interno de TraceEnabled.
+  */
+extern std::atomic<int> trace_state;
+
+/**
+  * @brief Consulta IMAGE_TRACE la primera vez y fija trace_state
+  * @return El estado de la traza, 0 o 1.
+  * @note Uso interno de TraceEnabled.
+  */
+int InitializeTrace ();
+
+/**
+  * @brief Instante actual, en nanosegundos desde el origen de la traza
+  * @note Uso interno de TraceScope.
+  */
+long long TraceNow ();
+
+/**
+  * @brief Registra un intervalo terminado en el buffer del hilo que llama
+  * @param name nombre del intervalo
+  * @param start instante de inicio, de TraceNow
+  * @note Uso interno de TraceScope.
+  */
+void RecordTrace (const char * name, long long start);
+
+/**
+  * @brief Comprueba si la traza está activa
+  *
+  * @return true si la variable de entorno IMAGE_TRACE contiene una ruta no vacía.
+  */
+inline bool TraceEnabled (){
+  int s= trace_state.load(std::memory_order_relaxed);
+  return (s < 0 ? InitializeTrace() : s) != 0;
+}
+
+/**
+  * @brief Guarda los intervalos registrados hasta el momento
+  *
+  * Se llama automáticamente al terminar el programa si la traza está activa. Los hilos
+  * que sigan ejecutando operaciones mientras se guarda pueden perder algún intervalo.
+  *
+  * @param file_path ruta del fichero JSON
+  * @return true si el fichero se ha escrito correctamente.
+  */
+bool SaveTrace (const char * file_path);
+
+/**
+  @brief Intervalo de la traza que dura lo que dura el objeto
+
+  Se registra al destruirse el objeto, en el hilo que lo creó. Los intervalos anidados
+  (una operación de Image y las bandas en que se reparte) aparecen anidados en la traza.
+**/
+class TraceScope {
+
+  private:
+
+    const char * name;      ///< Nombre del intervalo. Debe ser una cadena constante
+    long long start;        ///< Instante de inicio en nanosegundos (-1 = traza inactiva)
+
+    TraceScope (const TraceScope&);              // No se puede copiar
+    TraceScope& operator= (const TraceScope&);
+
+  public:
+
+    /**
+      * @brief Empieza un intervalo
+      * @param name nombre del intervalo. No se copia: debe ser un literal o durar todo el programa.
+      */
+    explicit TraceScope (const char * name) : name(name){
+      start= TraceEnabled() ? TraceNow() : -1;
+    }
+
+    /**
+      * @brief Termina el intervalo y lo registra
+      */
+    ~TraceScope (){
+      if (start >= 0)
+        RecordTrace(name, start);
+    }
+};
+
+#define IMAGE_TRACE_CONCAT2(a, b) a##b
+#define IMAGE_TRACE_CONCAT(a, b) IMAGE_TRACE_CONCAT2(a, b)
+
+/**
+  * @brief Registra un intervalo desde este punto hasta el final del bloque
+  * @param name nombre del intervalo (literal)
+  */
+#ifdef IMAGE_NO_TRACE
+#define IMAGE_TRACE_SCOPE(name) ((void) 0)
+#else
+#define IMAGE_TRACE_SCOPE(name) TraceScope IMAGE_TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#endif
+
+#endif
+
+/* Fin Fichero: imageTrace.h */
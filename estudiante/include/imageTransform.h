@@ -0,0 +1,57 @@
+/**
+  * @file imageTransform.h
+  * @brief Fichero cabecera para los núcleos de reordenación de píxeles
+  *
+  * Trasposición y permutaciones de columnas sobre vistas. Los giros se obtienen
+  * trasponiendo vistas con la separación entre filas negativa (filas en orden inverso),
+  * sin copias intermedias.
+  *
+  */
+
+#ifndef _IMAGEN_TRANSFORMACION_H_
+#define _IMAGEN_TRANSFORMACION_H_
+
+#include <cstddef>
+
+class ImageView;
+class MutableImageView;
+
+/**
+  * @brief Traspone una vista: dst(j, i) = src(i, j)
+  *
+  * El recorrido es por bloques de 64 x 64 píxeles, de modo que tanto las filas que se
+  * leen como las que se escriben permanecen en caché mientras se procesa el bloque, y
+  * dentro de cada bloque se usa TransposeBlock16. Los bloques se reparten entre hilos.
+  *
+  * @param src vista de origen
+  * @param dst vista de destino
+  * @pre dst.get_rows() == src.get_cols() y dst.get_cols() == src.get_rows(); las vistas
+  * no se solapan.
+  */
+void Transpose (const ImageView& src, const MutableImageView& dst);
+
+/**
+  * @brief Invierte el orden de las columnas de una vista: dst(i, j) = src(i, cols-1-j)
+  *
+  * @param src vista de origen
+  * @param dst vista de destino, de las mismas dimensiones
+  * @pre Las vistas no se solapan.
+  */
+void MirrorColumns (const ImageView& src, const MutableImageView& dst);
+
+/**
+  * @brief Reordena las columnas de una vista en su sitio: la columna j pasa a ser la
+  * columna @a perm[j] anterior
+  *
+  * Cada fila se copia a un buffer y se recompone a partir de él, de modo que el
+  * recorrido es siempre por filas. Las filas se reparten entre hilos.
+  *
+  * @param view vista que se modifica
+  * @param perm tabla de view.get_cols() posiciones
+  * @pre @a perm es una permutación de 0, ..., view.get_cols()-1
+  */
+void PermuteColumns (const MutableImageView& view, const ptrdiff_t *perm);
+
+#endif
+
+/* Fin Fichero: imageTransform.h */
@@ -0,0 +1,330 @@
+/**
+ * @file imageView.h
+ * @brief Cabecera para las clases ImageView y MutableImageView
+ */
+
+#ifndef _IMAGEN_VISTA_H_
+#define _IMAGEN_VISTA_H_
+
+#include <cstddef>
+
+#include <imageIO.h>
+#include <imageScale.h>
+
+typedef unsigned char byte;
+
+class Image;
+class ImageHistogram;
+
+
+/**
+  @brief T.D.A. Vista de imagen
+
+  Una instancia de ImageView es una ventana rectangular de solo lectura sobre los píxeles de otra imagen.
+  No reserva ni copia memoria: almacena el origen de la ventana, sus dimensiones y la separación (stride)
+  entre filas consecutivas del buffer al que apunta. Crearla, copiarla o recortarla cuesta O(1).
+
+  La vista no es propietaria de los píxeles, de modo que solo es válida mientras lo sea la imagen de la que
+  procede.
+
+  Para poder usar el TDA ImageView se debe incluir el fichero
+
+  \#include <image.h>
+
+**/
+
+class ImageView{
+
+protected :
+
+    /**
+      @brief Puntero al píxel (0, 0) de la vista.
+    **/
+    byte *origin;
+
+    /**
+      @brief Número de filas de la vista.
+    **/
+    ptrdiff_t rows;
+
+    /**
+      @brief Número de columnas de la vista.
+    **/
+    ptrdiff_t cols;
+
+    /**
+      @brief Número de bytes entre el comienzo de dos filas consecutivas.
+    **/
+    ptrdiff_t stride;
+
+    /**
+      @brief Ajusta una región a los límites de la vista.
+      @param nrow Fila de la esquina superior izquierda de la región.
+      @param ncol Columna de la esquina superior izquierda de la región.
+      @param height Altura de la región.
+      @param width Anchura de la región.
+      @post Si la región queda fuera de la vista, @p height y @p width valen 0. En otro caso se recortan
+      para que la región no sobrepase los límites de la vista.
+    **/
+    void Clip(ptrdiff_t nrow, ptrdiff_t ncol, ptrdiff_t & height, ptrdiff_t & width) const;
+
+public :
+
+    /**
+      * @brief Constructor por defecto.
+      * @post Genera una vista vacía, con 0 filas y 0 columnas.
+      */
+    ImageView();
+
+    /**
+      * @brief Constructor con parámetros.
+      * @param data Puntero al píxel (0, 0) de la vista.
+      * @param nrows Número de filas de la vista.
+      * @param ncols Número de columnas de la vista.
+      * @param nstride Número de bytes entre el comienzo de dos filas consecutivas.
+      * @pre @p nstride >= @p ncols
+      */
+    ImageView(const byte * data, ptrdiff_t nrows, ptrdiff_t ncols, ptrdiff_t nstride);
+
+    /**
+      * @brief Funcion para conocer si una vista está vacía.
+      * @return Si la vista está vacía
+      */
+    bool Empty() const;
+
+    /**
+      * @brief Filas de la vista.
+      * @return El número de filas de la vista.
+      */
+    ptrdiff_t get_rows() const;
+
+    /**
+      * @brief Columnas de la vista.
+      * @return El número de columnas de la vista.
+      */
+    ptrdiff_t get_cols() const;
+
+    /**
+      * @brief Separación entre filas.
+      * @return El número de bytes entre el comienzo de dos filas consecutivas.
+      */
+    ptrdiff_t get_stride() const;
+
+    /**
+      * @brief Devuelve el número de píxeles de la vista.
+      * @return número de píxeles de la vista.
+      */
+    size_t size() const;
+
+    /**
+      * @brief Consulta el valor del píxel (@p i, @p j) de la vista.
+      * @param i Fila de la vista.
+      * @param j Columna de la vista.
+      * @pre 0 <= @p i < get_rows() y 0 <= @p j < get_cols()
+      * @return el valor del píxel contenido en (@p i, @p j)
+      */
+    byte get_pixel(ptrdiff_t i, ptrdiff_t j) const;
+
+    /**
+      * @brief Acceso a una fila de la vista.
+      * @param i Fila de la vista.
+      * @pre 0 <= @p i < get_rows()
+      * @return Puntero al primer píxel de la fila @p i. Sus get_cols() bytes son consecutivos.
+      */
+    const byte * row(ptrdiff_t i) const;
+
+    /**
+      * @brief Almacena la vista en disco como imagen PGM.
+      * @param file_path Ruta donde se almacenará la imagen.
+      * @param mode Combinación de valores de SaveMode (ver imageIO.h).
+      * @return Devuelve true si la imagen se almacenó con éxito y false en caso contrario.
+      */
+    bool Save(const char * file_path, unsigned mode = SAVE_DEFAULT) const;
+
+    /**
+     * @brief Genera una subvista a partir de la vista dada, sin copiar píxeles.
+     * @param nrow Número de fila donde se coloca la esquina izquierda de la subvista
+     * @param ncol Número de columna donde se coloca la esquina izquierda de la subvista
+     * @param height Altura de la subvista = número de filas
+     * @param width Anchura de la subvista = número de columnas
+     * @pre @p nrow, @p ncol,@p height,@p width >= 0
+     * @return Devuelve la subvista
+     * @post En caso de que el tamaño de la subvista sobrepase los límites de la vista original,
+     * se ajustará su tamaño.
+     */
+    ImageView Crop(ptrdiff_t nrow, ptrdiff_t ncol, ptrdiff_t height, ptrdiff_t width) const;
+
+    /**
+     * @brief Genera una vista con las filas en orden inverso, sin copiar píxeles.
+     * @return Vista cuya fila i es la fila get_rows()-1-i de esta. Su separación entre filas es negativa.
+     */
+    ImageView FlipRows() const;
+
+    /**
+     * @brief Calcula la media de los píxeles de un fragmento de la vista
+     * @param i Fila de la esquina superior izquierda del fragmento
+     * @param j Columna de la esquina superior izquierda del fragmento
+     * @param height Altura del fragmento
+     * @param width Anchura del fragmento
+     * @return Devuleve la media aritmética del fragmento
+     * @pre 0 <= @p i + @p height <= get_rows()
+     * @pre 0 <= @p j + @p width <= get_cols()
+     */
+    double Mean(ptrdiff_t i, ptrdiff_t j, ptrdiff_t height, ptrdiff_t width) const;
+
+    /**
+     * @brief Calcula el histograma de los píxeles de la vista
+     * @see Image::Histogram
+     */
+    ImageHistogram Histogram() const;
+
+    /**
+     * @brief Genera una imagen reducida a partir de la vista
+     * @param factor Valor de reducción de la imagen (ej: factor=2 => width= ncols/2 )
+     * @pre @p factor > 0
+     * @return Devuelve la imagen reducida
+     * @see Image::Subsample
+     */
+    Image Subsample(ptrdiff_t factor) const;
+
+    /**
+     * @brief Genera una imagen aumentada a doble de tamaño a partir de la vista
+     * @return Devuelve la imagen aumentada
+     * @see Image::Zoom2X
+     */
+    Image Zoom2X() const;
+
+    /**
+     * @brief Genera una imagen con la vista escalada a unas dimensiones cualesquiera
+     * @param new_rows Filas de la imagen resultado
+     * @param new_cols Columnas de la imagen resultado
+     * @param filter Filtro de interpolación
+     * @return Devuelve la imagen escalada, o una imagen vacía si la vista está vacía o alguna de las
+     * dimensiones pedidas no es positiva.
+     * @see Image::Resize
+     */
+    Image Resize(ptrdiff_t new_rows, ptrdiff_t new_cols, ResizeFilter filter = RESIZE_BILINEAR) const;
+
+    /**
+     * @brief Genera la imagen traspuesta de la vista
+     * @see Image::Transpose
+     */
+    Image Transpose() const;
+
+    /**
+     * @brief Genera una imagen con la vista girada
+     * @see Image::Rotate
+     */
+    Image Rotate(int degrees) const;
+
+};
+
+
+/**
+  @brief T.D.A. Vista de imagen modificable
+
+  Igual que ImageView, pero permite modificar los píxeles de la imagen a la que apunta. Las operaciones
+  puntuales (Invert, AdjustContrast) trabajan sobre la región de la vista sin tocar el resto de la imagen.
+
+**/
+
+class MutableImageView : public ImageView{
+
+public :
+
+    /**
+      * @brief Constructor por defecto.
+      * @post Genera una vista vacía, con 0 filas y 0 columnas.
+      */
+    MutableImageView();
+
+    /**
+      * @brief Constructor con parámetros.
+      * @param data Puntero al píxel (0, 0) de la vista.
+      * @param nrows Número de filas de la vista.
+      * @param ncols Número de columnas de la vista.
+      * @param nstride Número de bytes entre el comienzo de dos filas consecutivas.
+      * @pre @p nstride >= @p ncols
+      */
+    MutableImageView(byte * data, ptrdiff_t nrows, ptrdiff_t ncols, ptrdiff_t nstride);
+
+    /**
+      * @brief Acceso a una fila de la vista.
+      * @param i Fila de la vista.
+      * @pre 0 <= @p i < get_rows()
+      * @return Puntero al primer píxel de la fila @p i.
+      */
+    byte * row(ptrdiff_t i) const;
+
+    /**
+      * @brief Asigna el valor @p value al píxel (@p i, @p j) de la vista.
+      * @param i Fila de la vista.
+      * @param j Columna de la vista.
+      * @param value Valor que se escribirá en el píxel.
+      * @pre 0 <= @p i < get_rows() y 0 <= @p j < get_cols()
+      */
+    void set_pixel(ptrdiff_t i, ptrdiff_t j, byte value) const;
+
+    /**
+     * @brief Genera una subvista modificable, sin copiar píxeles.
+     * @see ImageView::Crop
+     */
+    MutableImageView Crop(ptrdiff_t nrow, ptrdiff_t ncol, ptrdiff_t height, ptrdiff_t width) const;
+
+    /**
+     * @brief Genera una vista modificable con las filas en orden inverso, sin copiar píxeles.
+     * @see ImageView::FlipRows
+     */
+    MutableImageView FlipRows() const;
+
+    /**
+    * @brief Invierte la tonalidad de los píxeles de la vista
+    * @post Los píxeles de la vista quedan modificados
+    */
+    void Invert() const;
+
+    /**
+     * @brief Sustituye cada píxel de la vista por su valor en una tabla de consulta
+     * @param lut Tabla de 256 entradas: el píxel de valor v pasa a valer lut[v]
+     * @post Los píxeles de la vista quedan modificados
+     */
+    void ApplyLUT(const byte lut[256]) const;
+
+     /**
+     * @brief Ajusta el contraste de los píxeles de la vista
+     * @see Image::AdjustContrast
+     * @post Los píxeles de la vista quedan modificados
+     */
+    void AdjustContrast(byte in1, byte in2, byte out1, byte out2) const;
+
+    /**
+     * @brief Ajusta el contraste de la vista a partir de su histograma
+     * @see Image::AutoContrast
+     * @post Los píxeles de la vista quedan modificados
+     */
+    void AutoContrast(double low = 1, double high = 99) const;
+
+    /**
+     * @brief Ecualiza el histograma de la vista
+     * @see Image::Equalize
+     * @post Los píxeles de la vista quedan modificados
+     */
+    void Equalize() const;
+
+};
+
+
+/**
+  * @brief Calcula la tabla de consulta equivalente a un ajuste de contraste.
+  * @param lut Tabla de 256 entradas donde se escribe el resultado.
+  * @param in1 Umbral inferior de la image de entrada
+  * @param in2 Umbral superior de la imagen de entrada
+  * @param out1 Umbral inferior de la imagen de salida
+  * @param out2 Umbral superior de la imagen de la salida
+  * @pre Las mismas que Image::AdjustContrast
+  * @post lut[v] es el valor que AdjustContrast asigna a un píxel de valor v.
+  */
+void ContrastLUT(byte lut[256], byte in1, byte in2, byte out1, byte out2);
+
+
+#endif // _IMAGEN_VISTA_H_
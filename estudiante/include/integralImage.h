@@ -0,0 +1,135 @@
+/**
+ * @file integralImage.h
+ * @brief Cabecera para la clase IntegralImage
+ */
+
+#ifndef _IMAGEN_INTEGRAL_H_
+#define _IMAGEN_INTEGRAL_H_
+
+#include <vector>
+#include "imageMemory.h"
+#include "imageView.h"
+
+
+/**
+  @brief T.D.A. Imagen integral (tabla de áreas sumadas)
+
+  Una instancia de IntegralImage almacena, para cada posición (i, j), la suma de todos los píxeles de la
+  imagen original que quedan por encima y a la izquierda de ella. Una vez construida (un único recorrido
+  de la imagen), la suma o la media de cualquier región rectangular se obtiene con cuatro consultas a la
+  tabla, independientemente del tamaño de la región.
+
+  La tabla ocupa (filas+1) x (columnas+1) enteros de 64 bits y no se actualiza si la imagen original
+  cambia: hay que volver a construirla.
+
+**/
+
+class IntegralImage{
+
+private :
+
+    /**
+      @brief Tabla de sumas acumuladas.
+
+      La posición (i, j) de la tabla, almacenada en table[i*(cols+1) + j], contiene la suma de los
+      píxeles (f, c) de la imagen con f < i y c < j. La primera fila y la primera columna valen 0.
+      Se reserva con AllocateBuffer, en el punto de reserva "IntegralImage".
+    **/
+    std::vector<unsigned long long, BufferAllocator<unsigned long long>> table;
+
+    /**
+      @brief Número de filas de la imagen indexada.
+    **/
+    ptrdiff_t rows;
+
+    /**
+      @brief Número de columnas de la imagen indexada.
+    **/
+    ptrdiff_t cols;
+
+    /**
+      @brief Ajusta una región a los límites de la imagen indexada, igual que ImageView::Crop.
+      @param i Fila de la esquina superior izquierda de la región.
+      @param j Columna de la esquina superior izquierda de la región.
+      @param height Altura de la región.
+      @param width Anchura de la región.
+    **/
+    void Clip(ptrdiff_t i, ptrdiff_t j, ptrdiff_t & height, ptrdiff_t & width) const;
+
+    /**
+      @brief Rellena la tabla repartiendo el cálculo entre hilos.
+      @param view Imagen (o región) que se indexa.
+      @pre La tabla tiene el tamaño de @p view y está a cero.
+    **/
+    void BuildParallel(const ImageView & view);
+
+public :
+
+    /**
+      * @brief Constructor por defecto.
+      * @post Genera una tabla vacía, que indexa una imagen de 0 filas y 0 columnas.
+      */
+    IntegralImage();
+
+    /**
+      * @brief Construye la tabla de una imagen.
+      * @param view Imagen (o región) que se indexa.
+      */
+    explicit IntegralImage(const ImageView & view);
+
+    /**
+      * @brief Reconstruye la tabla para otra imagen.
+      * @param view Imagen (o región) que se indexa.
+      * @post La tabla anterior se descarta.
+      */
+    void Build(const ImageView & view);
+
+    /**
+      * @brief Libera la memoria de la tabla.
+      * @post La tabla queda vacía.
+      */
+    void Clear();
+
+    /**
+      * @brief Intercambia el contenido de dos tablas sin copiarlas.
+      * @param other Tabla con la que intercambiar.
+      */
+    void swap(IntegralImage & other) noexcept;
+
+    /**
+      * @brief Filas de la imagen indexada.
+      * @return El número de filas de la imagen indexada.
+      */
+    ptrdiff_t get_rows() const;
+
+    /**
+      * @brief Columnas de la imagen indexada.
+      * @return El número de columnas de la imagen indexada.
+      */
+    ptrdiff_t get_cols() const;
+
+    /**
+     * @brief Suma los píxeles de una región rectangular en O(1).
+     * @param i Fila de la esquina superior izquierda de la región
+     * @param j Columna de la esquina superior izquierda de la región
+     * @param height Altura de la región
+     * @param width Anchura de la región
+     * @return La suma de los píxeles de la región. Si la región sobrepasa los límites de la imagen se
+     * ajusta igual que en ImageView::Crop.
+     */
+    unsigned long long Sum(ptrdiff_t i, ptrdiff_t j, ptrdiff_t height, ptrdiff_t width) const;
+
+    /**
+     * @brief Calcula la media de los píxeles de una región rectangular en O(1).
+     * @param i Fila de la esquina superior izquierda de la región
+     * @param j Columna de la esquina superior izquierda de la región
+     * @param height Altura de la región
+     * @param width Anchura de la región
+     * @return El mismo valor que ImageView::Mean sobre la imagen indexada.
+     */
+    double Mean(ptrdiff_t i, ptrdiff_t j, ptrdiff_t height, ptrdiff_t width) const;
+
+};
+
+
+#endif // _IMAGEN_INTEGRAL_H_
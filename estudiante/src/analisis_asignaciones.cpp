@@ -0,0 +1,82 @@
+//
+// Fichero: analisis_asignaciones.cpp
+// Cuenta las reservas de buffers de píxeles y memorias intermedias que hace cada cadena de operaciones
+//
+
+#include <iostream>
+#include <utility>
+#include <image.h>
+#include <imageMemory.h>
+
+using namespace std;
+
+// Muestra las reservas hechas desde la consulta before hasta ahora, y el pico de memoria
+// por encima de la que había entonces. Reinicia el pico para el siguiente fragmento
+void report(const char * pipeline, const AllocationStats & before) {
+    AllocationStats after = GetAllocationStats();
+
+    cout << pipeline << "\t" << after.allocations - before.allocations
+         << "\t" << after.bytes - before.bytes << "\t" << after.peak - before.current
+         << "\t" << after.current << endl;
+    ResetPeakAllocation();
+}
+
+int main (int argc, char *argv[]) {
+
+    const int N = 1024; // Lado de la imagen sintética
+    AllocationStats before;
+
+    cout << "Cadena\tReservas\tBytes\tPico\tEn uso" << endl;
+    ResetPeakAllocation();
+
+    before = GetAllocationStats();
+    Image image (N, N, 128);
+    report("Image(N,N)", before);
+
+    if (argc > 1) {
+        before = GetAllocationStats();
+        if (!image.Load(argv[1])) {
+            cerr << "Error: No pudo leerse la imagen " << argv[1] << endl;
+            return 1;
+        }
+        report("Load", before);
+    }
+
+    before = GetAllocationStats();
+    Image copy (image);
+    report("Image(const Image &)", before);
+
+    before = GetAllocationStats();
+    Image moved (std::move(copy));
+    report("Image(Image &&)", before);
+
+    before = GetAllocationStats();
+    copy = std::move(moved);
+    report("operator=(Image &&)", before);
+
+    before = GetAllocationStats();
+    swap(copy, moved);
+    report("swap", before);
+
+    before = GetAllocationStats();
+    Image zoomed = image.Crop(0, 0, N/2, N/2).Zoom2X();
+    report("Crop().Zoom2X()", before);
+
+    before = GetAllocationStats();
+    zoomed = image.Crop(0, 0, N/4, N/4).Zoom2X();
+    report("x = Crop().Zoom2X()", before);
+
+    before = GetAllocationStats();
+    Image icon = image.Subsample(8);
+    report("Subsample(8)", before);
+
+    before = GetAllocationStats();
+    image.ShuffleRows();
+    report("ShuffleRows", before);
+
+    cout << endl << "Punto de reserva\tReservas\tBytes\tEn uso" << endl;
+    for (const AllocationSite & site : GetAllocationSites())
+        cout << site.site << "\t" << site.allocations << "\t" << site.bytes << "\t" << site.current << endl;
+
+    return 0;
+}
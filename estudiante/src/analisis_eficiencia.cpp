@@ -1,49 +1,610 @@
 //
-// Created by gonzalomp on 16/10/22.
+// Fichero: analisis_eficiencia.cpp
+// Mide el tiempo de las operaciones de Image sobre imágenes de distintos tamaños y proporciones
 //
 
 #include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
 #include <chrono>
-#include <image.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
 #include <vector>
-#include <stdlib.h>
+#include <unistd.h>
+#include <image.h>
+#include <imageCounters.h>
+#include <imageMemory.h>
+#include <imageThreads.h>
 
 using namespace std;
 
-void chrono_experiment(int n, int repetitions) {
+typedef chrono::steady_clock reloj;
 
-    const int N = 1500; // Valor fijo
+// Operación medida: prepare se ejecuta antes de cada muestra sin contar en el tiempo (puede
+// ser nula) y run es lo que se mide
+struct Experiment {
+    string name;
+    function<void ()> prepare;
+    function<void ()> run;
+};
 
-    // Inicializamos el experimento antes del bucle de conteo de tiempo para no afectar al análisis
-    Image prueba (n,n);
+// Resultado de medir una operación sobre un tamaño de imagen. Los tiempos, en segundos
+struct Measure {
+    string name;
+    ptrdiff_t rows, cols;
+    size_t repetitions;
+    double min, median, p95, mean;
+    bool counted[COUNTER_EVENTS];       // el evento se midió
+    double counters[COUNTER_EVENTS];    // media de eventos por repetición
+    double allocations;                 // media de buffers reservados por repetición
+    size_t peak;                        // máximo de bytes reservados por encima de los previos
+};
 
+// Parámetros de la ejecución
+struct Options {
+    double budget = 0.25;           // segundos de medida por operación y tamaño
+    size_t warmup = 2;              // ejecuciones previas que no se miden
+    size_t min_repetitions = 5;
+    size_t max_repetitions = 1000;
+    bool quick = false;             // solo tamaños pequeños
+    vector<string> operations;      // vacío = todas
+    const char * csv = 0;
+    const char * json = 0;
+    PerfCounters * counters = 0;    // contadores hardware (--counters), o nulo
+    bool sweep = false;             // cuadradas de lado 100 a 3000 (--sweep)
+    const char * baseline = 0;      // JSON de una ejecución anterior con el que comparar
+    double threshold = 0.15;        // empeoramiento relativo de la mediana que se admite
+};
+
+// Valor del percentil p (0..100) de unas muestras ordenadas, por el método del rango más próximo
+double percentile(const vector<double> & sorted, double p) {
+    size_t rank = (size_t) ceil(p / 100 * sorted.size());
+    return sorted[max<size_t>(rank, 1) - 1];
+}
 
-    // Medimos el tiempo antes de iniciar el expermiento
-    chrono::high_resolution_clock::time_point start_time = chrono::high_resolution_clock::now();
+// Ejecuta el experimento hasta agotar el presupuesto de tiempo (con un mínimo y un máximo de
+// repeticiones), midiendo cada repetición por separado. Los contadores hardware y de memoria
+// se consultan fuera del intervalo cronometrado
+Measure measure(const Experiment & e, ptrdiff_t rows, ptrdiff_t cols, const Options & options) {
+    vector<double> samples;
+    double events[COUNTER_EVENTS] = {0};
+    size_t allocations = 0, peak = 0;
 
-    // Realizamos el experimento tantas veces como indique repetitions, para tener cierta robustez
-    // en el resultado (no todas las ejecuciones tardan lo mismo)
-    for (int k = 0; k < repetitions; ++k){
-        prueba.ShuffleRows();
+    for (size_t k = 0; k < options.warmup; k++) {
+        if (e.prepare)
+            e.prepare();
+        e.run();
     }
 
-    // Medimos el tiempo al finalizar el experimento
-    chrono::high_resolution_clock::time_point finish_time = chrono::high_resolution_clock::now();
+    double total = 0;
+    while (samples.size() < options.min_repetitions ||
+           (total < options.budget && samples.size() < options.max_repetitions)) {
+        if (e.prepare)
+            e.prepare();
+
+        ResetPeakAllocation();
+        AllocationStats before = GetAllocationStats();
+
+        if (options.counters)
+            options.counters->Start();
+
+        reloj::time_point start = reloj::now();
+        e.run();
+        chrono::duration<double> elapsed = reloj::now() - start;
 
-    // Calculamos la diferencia entre el inicio y el final
-    chrono::duration<double> total_duration = chrono::duration_cast<chrono::duration<double>>(finish_time - start_time);
+        if (options.counters) {
+            options.counters->Stop();
+            for (int c = 0; c < COUNTER_EVENTS; c++)
+                events[c] += options.counters->Value((CounterEvent) c);
+        }
 
-    // Dividimos el tiempo total entre el número de repeticiones para obtener el tiempo medio por ejecución
-    cout << n << "\t" << total_duration.count()/repetitions << endl;
+        AllocationStats after = GetAllocationStats();
+        allocations += after.allocations - before.allocations;
+        peak = max(peak, after.peak - before.current);
+
+        samples.push_back(elapsed.count());
+        total += elapsed.count();
+    }
+
+    sort(samples.begin(), samples.end());
+
+    Measure m;
+    m.name = e.name;
+    m.rows = rows;
+    m.cols = cols;
+    m.repetitions = samples.size();
+    m.min = samples.front();
+    m.median = percentile(samples, 50);
+    m.p95 = percentile(samples, 95);
+    m.mean = total / samples.size();
+    m.allocations = (double) allocations / samples.size();
+    m.peak = peak;
+    for (int c = 0; c < COUNTER_EVENTS; c++) {
+        m.counted[c] = options.counters && options.counters->Available((CounterEvent) c);
+        m.counters[c] = events[c] / samples.size();
+    }
+    return m;
 }
 
-int main () {
+// Operaciones medidas sobre una imagen de rows x cols con contenido pseudoaleatorio. El estado
+// de cada operación se comparte entre prepare y run con shared_ptr
+vector<Experiment> experiments(ptrdiff_t rows, ptrdiff_t cols, const string & path) {
+    shared_ptr<Image> image = make_shared<Image>(rows, cols);
+    unsigned state = 12345;
+    for (ptrdiff_t k = 0; k < rows * cols; k++) {
+        state = state * 1103515245 + 12345;
+        image->set_pixel(k, state >> 24);
+    }
+    image->Save(path.c_str());
+
+    shared_ptr<Image> work = make_shared<Image>(*image);
+    shared_ptr<Image> result = make_shared<Image>();
 
-    for (int i = 100; i <= 3000; i += 100){
-        chrono_experiment(i, 30);
+    vector<Experiment> list = {
+        {"Load", nullptr, [=]{ result->Load(path.c_str()); }},
+        {"Save", nullptr, [=]{ image->Save(path.c_str()); }},
+        {"Invert", nullptr, [=]{ work->Invert(); }},
+        {"AdjustContrast", nullptr, [=]{ work->AdjustContrast(40, 200, 10, 240); }},
+        // Al modificar un píxel se invalida la imagen integral: cada muestra mide la suma directa
+        // de la imagen, como una consulta aislada de los programas
+        {"Mean", [=]{ work->set_pixel(0, work->get_pixel(0)); },
+                 [=]{ volatile double mean = work->Mean(0, 0, rows, cols); (void) mean; }},
+        {"Subsample", nullptr, [=]{ *result = image->Subsample(4); }},
+        // Crop solo crea una vista: se mide también la copia a una imagen nueva, como en subimagen
+        {"Crop", nullptr, [=]{ *result = Image(image->Crop(rows / 4, cols / 4, rows / 2, cols / 2)); }},
+        {"Zoom2X", nullptr, [=]{ *result = image->Zoom2X(); }},
+        {"ShuffleRows", nullptr, [=]{ work->ShuffleRows(); }}
+    };
+    return list;
+}
+
+// Métricas derivadas de los contadores: instrucciones por ciclo y fallos por píxel. Devuelven
+// un valor negativo si no se midieron los eventos necesarios
+double ipc(const Measure & m) {
+    if (!m.counted[COUNTER_CYCLES] || !m.counted[COUNTER_INSTRUCTIONS] || m.counters[COUNTER_CYCLES] == 0)
+        return -1;
+    return m.counters[COUNTER_INSTRUCTIONS] / m.counters[COUNTER_CYCLES];
+}
+
+double per_pixel(const Measure & m, CounterEvent event) {
+    if (!m.counted[event])
+        return -1;
+    return m.counters[event] / (m.rows * m.cols);
+}
+
+const CounterEvent MISSES[] = {COUNTER_L1D_MISSES, COUNTER_LLC_MISSES, COUNTER_BRANCH_MISSES, COUNTER_DTLB_MISSES};
+
+void write_csv(const char * file, const vector<Measure> & results) {
+    ofstream out(file);
+    out << "operation,rows,cols,pixels,repetitions,min_s,median_s,p95_s,mean_s,mpixels_per_s,allocations,peak_bytes,ipc";
+    for (CounterEvent event : MISSES)
+        out << "," << CounterName(event) << "_per_pixel";
+    out << "\n";
+
+    // Las métricas de contadores no medidos quedan vacías
+    for (const Measure & m : results) {
+        out << m.name << "," << m.rows << "," << m.cols << "," << m.rows * m.cols << ","
+            << m.repetitions << "," << m.min << "," << m.median << "," << m.p95 << "," << m.mean << ","
+            << m.rows * m.cols / m.median / 1e6 << "," << m.allocations << "," << m.peak << ",";
+        if (ipc(m) >= 0)
+            out << ipc(m);
+        for (CounterEvent event : MISSES) {
+            out << ",";
+            if (per_pixel(m, event) >= 0)
+                out << per_pixel(m, event);
+        }
+        out << "\n";
+    }
+}
+
+void write_json(const char * file, const vector<Measure> & results) {
+    ofstream out(file);
+    out << "[\n";
+    for (size_t k = 0; k < results.size(); k++) {
+        const Measure & m = results[k];
+        out << "  {\"operation\": \"" << m.name << "\", \"rows\": " << m.rows << ", \"cols\": " << m.cols
+            << ", \"pixels\": " << m.rows * m.cols << ", \"repetitions\": " << m.repetitions
+            << ", \"min_s\": " << m.min << ", \"median_s\": " << m.median << ", \"p95_s\": " << m.p95
+            << ", \"mean_s\": " << m.mean << ", \"mpixels_per_s\": " << m.rows * m.cols / m.median / 1e6
+            << ", \"allocations\": " << m.allocations << ", \"peak_bytes\": " << m.peak;
+
+        // Las métricas de contadores no medidos valen null
+        out << ", \"ipc\": ";
+        if (ipc(m) >= 0)
+            out << ipc(m);
+        else
+            out << "null";
+        for (CounterEvent event : MISSES) {
+            out << ", \"" << CounterName(event) << "_per_pixel\": ";
+            if (per_pixel(m, event) >= 0)
+                out << per_pixel(m, event);
+            else
+                out << "null";
+        }
+        out << "}" << (k + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+// _____________________________________________________________________________
+// Ajuste de complejidad
+
+// Modelos t(n) = a + b * f(n), con n el número de píxeles. El término constante recoge el
+// coste fijo de cada llamada, que domina en las imágenes pequeñas
+struct Model {
+    const char * name;
+    double (*f)(double);
+};
+
+const Model MODELS[] = {
+    {"O(1)", [](double) { return 0.0; }},
+    {"O(n)", [](double n) { return n; }},
+    {"O(n log n)", [](double n) { return n * log2(n); }},
+    {"O(n^2)", [](double n) { return n * n; }}
+};
+
+const size_t NUM_MODELS = sizeof(MODELS) / sizeof(MODELS[0]);
+
+// Coeficientes y error cuadrático medio relativo del ajuste de un modelo
+struct Fit {
+    double a, b, error;
+};
+
+// Mínimos cuadrados ponderados con 1/t_i^2, es decir, sobre el error relativo (t_i - a - b f_i) / t_i:
+// los tiempos abarcan varios órdenes de magnitud y con el error absoluto solo contarían los tamaños
+// mayores. f se normaliza a [0, 1] para que las sumas no pierdan precisión, y si algún coeficiente
+// sale negativo se ajusta sin él
+Fit fit(const Model & model, const vector<Measure> & series) {
+    double scale = 0;
+    for (const Measure & m : series)
+        scale = max(scale, model.f(m.rows * m.cols));
+
+    double S = 0, Sf = 0, Sff = 0, St = 0, Sft = 0;
+    for (const Measure & m : series) {
+        double w = 1 / (m.median * m.median);
+        double f = scale > 0 ? model.f(m.rows * m.cols) / scale : 0;
+        S += w;
+        Sf += w * f;
+        Sff += w * f * f;
+        St += w * m.median;
+        Sft += w * f * m.median;
+    }
+
+    Fit result;
+    double det = S * Sff - Sf * Sf;
+    result.b = det > 0 ? (S * Sft - Sf * St) / det : 0;
+    result.a = (St - result.b * Sf) / S;
+
+    if (result.b < 0) {
+        result.b = 0;
+        result.a = St / S;
+    }
+    else if (result.a < 0) {
+        result.a = 0;
+        result.b = Sft / Sff;
+    }
+
+    result.error = 0;
+    for (const Measure & m : series) {
+        double f = scale > 0 ? model.f(m.rows * m.cols) / scale : 0;
+        double r = (m.median - result.a - result.b * f) / m.median;
+        result.error += r * r;
+    }
+    result.error = sqrt(result.error / series.size());
+    if (scale > 0)
+        result.b /= scale;
+    return result;
+}
+
+// Un modelo de orden mayor mejora claramente a otro si reduce su error a menos de la mitad y en
+// al menos 2 puntos: con pocos tamaños, o con tiempos dominados por el coste fijo, los modelos
+// de orden mayor se ajustan al ruido y casi siempre dan un error algo menor
+const double MODEL_GAIN = 0.5;
+const double MODEL_MIN_GAIN = 0.02;
+
+// Tamaños distintos necesarios: con dos, cualquier modelo con término constante pasa por ambos
+const size_t MIN_SIZES = 3;
+
+bool clearly_better(const Fit & higher, const Fit & lower) {
+    return higher.b > 0 && higher.error < lower.error * MODEL_GAIN && lower.error - higher.error >= MODEL_MIN_GAIN;
+}
+
+// Ajusta todos los modelos a las medidas de cada operación y muestra el elegido: el de menor
+// orden al que ningún modelo de orden mayor mejora claramente. Un ajuste con b = 0 es el modelo
+// constante y no mejora a ninguno
+void report_complexity(const vector<Measure> & results) {
+    vector<string> names;
+    for (const Measure & m : results)
+        if (find(names.begin(), names.end(), m.name) == names.end())
+            names.push_back(m.name);
+
+    cout << endl << "Complejidad (n = pixeles, t = a + b * f(n)):" << endl;
+
+    for (const string & name : names) {
+        vector<Measure> series;
+        vector<ptrdiff_t> sizes;
+        for (const Measure & m : results)
+            if (m.name == name) {
+                series.push_back(m);
+                if (find(sizes.begin(), sizes.end(), m.rows * m.cols) == sizes.end())
+                    sizes.push_back(m.rows * m.cols);
+            }
+
+        cout << "   " << left << setw(16) << name << right;
+        if (sizes.size() < MIN_SIZES) {
+            cout << "insuficiente (" << sizes.size() << " tamanos distintos, se necesitan " << MIN_SIZES << ")" << endl;
+            continue;
+        }
+
+        Fit fits[NUM_MODELS];
+        for (size_t k = 0; k < NUM_MODELS; k++)
+            fits[k] = fit(MODELS[k], series);
+
+        size_t best = 0;
+        for (bool improved = true; improved; ) {
+            improved = false;
+            for (size_t k = best + 1; k < NUM_MODELS && !improved; k++)
+                improved = clearly_better(fits[k], fits[best]);
+            if (improved)
+                best++;
+        }
+
+        cout << left << setw(12) << MODELS[best].name << right << scientific << setprecision(3)
+             << "a = " << fits[best].a << " s   b = " << fits[best].b << " s" << fixed << setprecision(1) << "   error " << setw(5)
+             << fits[best].error * 100 << "%   [";
+        for (size_t k = 0; k < NUM_MODELS; k++)
+            cout << (k ? ", " : "") << MODELS[k].name << " " << fits[k].error * 100 << "%";
+        cout << "]" << endl;
+    }
+}
+
+// _____________________________________________________________________________
+// Comparación con una ejecución anterior
+
+// Extrae el valor de una clave de un objeto JSON plano, tal como lo escribe write_json
+string json_value(const string & object, const string & key) {
+    size_t pos = object.find("\"" + key + "\"");
+    if (pos == string::npos)
+        return "";
+    pos = object.find(':', pos);
+    if (pos == string::npos)
+        return "";
+    pos = object.find_first_not_of(" \"", pos + 1);
+    size_t end = object.find_first_of(",\"}", pos);
+    return object.substr(pos, end - pos);
+}
+
+// Lee las medidas de un fichero escrito con --json. Solo se usan el nombre, el tamaño y la mediana
+bool read_baseline(const char * file, vector<Measure> & baseline) {
+    ifstream in(file);
+    if (!in)
+        return false;
+
+    string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    size_t start;
+    while ((start = text.find('{')) != string::npos) {
+        size_t end = text.find('}', start);
+        if (end == string::npos)
+            break;
+        string object = text.substr(start, end - start + 1);
+        text.erase(0, end + 1);
+
+        Measure m = Measure();
+        m.name = json_value(object, "operation");
+        m.rows = atol(json_value(object, "rows").c_str());
+        m.cols = atol(json_value(object, "cols").c_str());
+        m.median = atof(json_value(object, "median_s").c_str());
+        if (!m.name.empty() && m.median > 0)
+            baseline.push_back(m);
+    }
+    return true;
+}
+
+// Diferencia mínima entre medianas para considerar una regresión: por debajo, el ruido del reloj
+// y del sistema supera a menudo el umbral relativo en las operaciones más rápidas
+const double NOISE_FLOOR = 5e-6;
+
+// Compara la mediana de cada operación y tamaño presentes en ambas ejecuciones y muestra las
+// medidas de la referencia que no se han repetido. Devuelve el número de regresiones (mediana
+// actual mayor que la anterior en más del umbral y en más de NOISE_FLOOR segundos), o -1 si
+// ninguna medida coincide con la referencia: entonces no se ha comprobado nada
+int compare(const vector<Measure> & results, const vector<Measure> & baseline, double threshold) {
+    int regressions = 0, compared = 0;
+
+    cout << endl << "Comparacion con la ejecucion de referencia (umbral " << fixed << setprecision(1)
+         << threshold * 100 << "%):" << endl;
+
+    for (const Measure & m : results)
+        for (const Measure & b : baseline) {
+            if (b.name != m.name || b.rows != m.rows || b.cols != m.cols)
+                continue;
+
+            double change = m.median / b.median - 1;
+            bool regression = change > threshold && m.median - b.median > NOISE_FLOOR;
+            regressions += regression;
+            compared++;
+
+            cout << "   " << left << setw(16) << m.name << right << setw(7) << m.rows << setw(7) << m.cols
+                 << setprecision(3) << setw(12) << b.median * 1e3 << " ms ->" << setw(10) << m.median * 1e3
+                 << " ms" << setprecision(1) << setw(9) << showpos << change * 100 << "%" << noshowpos
+                 << (regression ? "   REGRESION" : "") << endl;
+        }
+
+    for (const Measure & b : baseline) {
+        bool found = false;
+        for (const Measure & m : results)
+            found = found || (b.name == m.name && b.rows == m.rows && b.cols == m.cols);
+        if (!found)
+            cout << "   " << left << setw(16) << b.name << right << setw(7) << b.rows << setw(7) << b.cols
+                 << "   sin medida en esta ejecucion" << endl;
+    }
+
+    if (compared == 0) {
+        cout << "   Ninguna medida coincide en operacion y tamano con la referencia" << endl;
+        return -1;
+    }
+
+    cout << "   " << regressions << " regresiones en " << compared << " medidas" << endl;
+    return regressions;
+}
+
+// _____________________________________________________________________________
+
+void usage() {
+    cerr << "Uso: eficiencia [--quick | --sweep] [--counters] [--budget <segundos>] [--ops <op1,op2,...>]\n";
+    cerr << "                [--csv <fichero>] [--json <fichero>] [--baseline <fichero.json>] [--threshold <fraccion>]\n";
+    cerr << "Operaciones: Load, Save, Invert, AdjustContrast, Mean, Subsample, Crop, Zoom2X, ShuffleRows\n";
+}
+
+bool parse(int argc, char * argv[], Options & options, bool & counters) {
+    for (int k = 1; k < argc; k++) {
+        string arg = argv[k];
+        bool has_value = k + 1 < argc;
+
+        if (arg == "--quick") {
+            options.quick = true;
+            options.budget = 0.05;
+        }
+        else if (arg == "--sweep") {
+            options.sweep = true;
+            options.budget = 0.05;
+        }
+        else if (arg == "--baseline" && has_value)
+            options.baseline = argv[++k];
+        else if (arg == "--threshold" && has_value)
+            options.threshold = atof(argv[++k]);
+        else if (arg == "--counters")
+            counters = true;
+        else if (arg == "--budget" && has_value)
+            options.budget = atof(argv[++k]);
+        else if (arg == "--csv" && has_value)
+            options.csv = argv[++k];
+        else if (arg == "--json" && has_value)
+            options.json = argv[++k];
+        else if (arg == "--ops" && has_value) {
+            string list = argv[++k];
+            size_t start = 0, comma;
+            do {
+                comma = list.find(',', start);
+                options.operations.push_back(list.substr(start, comma - start));
+                start = comma + 1;
+            } while (comma != string::npos);
+        }
+        else
+            return false;
+    }
+    return true;
+}
+
+int main (int argc, char *argv[]) {
+
+    Options options;
+    bool counters = false;
+    if (!parse(argc, argv, options, counters)) {
+        usage();
+        return 1;
+    }
+
+    // Los contadores solo cuentan en el hilo que los abre: las operaciones se ejecutan en él
+    PerfCounters hardware;
+    if (counters) {
+        if (hardware.Available()) {
+            options.counters = &hardware;
+            SetThreadCount(1);
+            cout << "Contadores hardware activos (operaciones en un solo hilo)" << endl;
+        }
+        else
+            cout << "Contadores hardware no disponibles (perf_event_open): solo se mide el tiempo" << endl;
+    }
+
+    // Cuadradas de varios tamaños y dos proporciones extremas con el mismo número de píxeles
+    const ptrdiff_t SIZES[][2] = {{256, 256}, {1024, 1024}, {2048, 2048}, {4096, 4096}, {512, 8192}, {8192, 512}};
+    const ptrdiff_t QUICK_SIZES[][2] = {{128, 128}, {256, 256}, {512, 512}, {256, 1024}, {1024, 256}};
+
+    // El barrido de la versión original: cuadradas de lado 100 a 3000
+    vector<pair<ptrdiff_t, ptrdiff_t>> sizes;
+    if (options.sweep)
+        for (ptrdiff_t n = 100; n <= 3000; n += 100)
+            sizes.push_back({n, n});
+    else if (options.quick)
+        for (auto & s : QUICK_SIZES)
+            sizes.push_back({s[0], s[1]});
+    else
+        for (auto & s : SIZES)
+            sizes.push_back({s[0], s[1]});
+
+    // La referencia se lee antes de medir, para no esperar a un error de lectura
+    vector<Measure> baseline;
+    if (options.baseline && !read_baseline(options.baseline, baseline)) {
+        cerr << "Error: No pudo leerse la referencia " << options.baseline << endl;
+        return 1;
+    }
+
+    const char * tmpdir = getenv("TMPDIR");
+    string path = string(tmpdir ? tmpdir : "/tmp") + "/eficiencia_" + to_string(getpid()) + ".pgm";
+
+    vector<Measure> results;
+
+    cout << left << setw(16) << "Operacion" << right << setw(7) << "Filas" << setw(7) << "Cols"
+         << setw(7) << "Reps" << setw(12) << "Min (ms)" << setw(12) << "Mediana" << setw(12) << "P95"
+         << setw(12) << "Mpix/s" << setw(10) << "Reservas" << setw(11) << "Pico (MB)";
+    if (options.counters) {
+        cout << setw(8) << "IPC";
+        for (CounterEvent event : MISSES)
+            cout << setw(16) << string(CounterName(event)) + "/px";
+    }
+    cout << endl;
+
+    for (auto & size : sizes) {
+        for (const Experiment & e : experiments(size.first, size.second, path)) {
+            if (!options.operations.empty() &&
+                find(options.operations.begin(), options.operations.end(), e.name) == options.operations.end())
+                continue;
+
+            Measure m = measure(e, size.first, size.second, options);
+            results.push_back(m);
+
+            cout << left << setw(16) << m.name << right << setw(7) << m.rows << setw(7) << m.cols
+                 << setw(7) << m.repetitions << fixed << setprecision(3)
+                 << setw(12) << m.min * 1e3 << setw(12) << m.median * 1e3 << setw(12) << m.p95 * 1e3
+                 << setprecision(1) << setw(12) << m.rows * m.cols / m.median / 1e6
+                 << setw(10) << m.allocations << setprecision(2) << setw(11) << m.peak / 1048576.0;
+            if (options.counters) {
+                cout << setprecision(2) << setw(8) << ipc(m) << setprecision(4);
+                for (CounterEvent event : MISSES)
+                    cout << setw(16) << per_pixel(m, event);
+            }
+            cout << endl;
+        }
+    }
+
+    remove(path.c_str());
+
+    if (options.csv)
+        write_csv(options.csv, results);
+    if (options.json)
+        write_json(options.json, results);
+
+    if (!results.empty())
+        report_complexity(results);
+
+    // Con regresiones, o si no ha podido compararse nada, el programa termina con código 2, para
+    // detenerlo en un script
+    if (options.baseline) {
+        int regressions = compare(results, baseline, options.threshold);
+        if (regressions != 0) {
+            cout << (regressions < 0 ? "SIN COMPARACION" : "REGRESION") << endl;
+            return 2;
+        }
     }
 
     cout << "OK" << endl;
 
     return 0;
-}
\ No newline at end of file
+}
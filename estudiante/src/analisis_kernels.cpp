@@ -0,0 +1,322 @@
+//
+// Fichero: analisis_kernels.cpp
+// Comprueba los núcleos vectorizados frente a la versión escalar y mide su rendimiento.
+// Con --check solo hace las comprobaciones, sin medir (así se ejecuta desde ctest)
+//
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <imageSimd.h>
+
+using namespace std;
+
+// Compara el núcleo del nivel activo con la definición (255 - x) en tramos de todas
+// las longitudes y desalineamientos pequeños, para cubrir las colas de cada versión
+bool check_invert() {
+    vector<unsigned char> src(512), dst(512);
+    for (size_t k = 0; k < src.size(); k++)
+        src[k] = rand() % 256;
+
+    for (size_t offset = 0; offset < 64; offset++)
+        for (size_t n = 0; offset + n <= 300; n++) {
+            memset(dst.data(), 0, dst.size());
+            InvertRow(dst.data() + offset, src.data() + offset, n);
+
+            for (size_t k = 0; k < dst.size(); k++) {
+                unsigned char expected = (k >= offset && k < offset + n) ? 255 - src[k] : 0;
+                if (dst[k] != expected)
+                    return false;
+            }
+        }
+
+    return true;
+}
+
+// Igual que check_invert, para ApplyLUTRow con una tabla aleatoria
+bool check_lut() {
+    vector<unsigned char> src(512), dst(512), lut(256);
+    for (size_t k = 0; k < src.size(); k++)
+        src[k] = k < 256 ? k : rand() % 256;
+    for (size_t k = 0; k < lut.size(); k++)
+        lut[k] = rand() % 256;
+
+    for (size_t offset = 0; offset < 64; offset++)
+        for (size_t n = 0; offset + n <= 300; n++) {
+            memset(dst.data(), 0, dst.size());
+            ApplyLUTRow(dst.data() + offset, src.data() + offset, n, lut.data());
+
+            for (size_t k = 0; k < dst.size(); k++) {
+                unsigned char expected = (k >= offset && k < offset + n) ? lut[src[k]] : 0;
+                if (dst[k] != expected)
+                    return false;
+            }
+        }
+
+    return true;
+}
+
+// Igual que check_invert, para AccumulateRow sobre contadores con valores previos
+bool check_accumulate() {
+    vector<unsigned char> src(512);
+    vector<unsigned short> acc(512), initial(512);
+    for (size_t k = 0; k < src.size(); k++) {
+        src[k] = rand() % 256;
+        initial[k] = rand() % 65000;
+    }
+
+    for (size_t offset = 0; offset < 64; offset++)
+        for (size_t n = 0; offset + n <= 300; n++) {
+            acc = initial;
+            AccumulateRow(acc.data() + offset, src.data() + offset, n);
+
+            for (size_t k = 0; k < acc.size(); k++) {
+                unsigned short expected = initial[k] + ((k >= offset && k < offset + n) ? src[k] : 0);
+                if (acc[k] != expected)
+                    return false;
+            }
+        }
+
+    return true;
+}
+
+// Comprueba ZoomEvenRow y ZoomOddRow con las medias redondeadas de Zoom2X, para filas de
+// todas las longitudes pequeñas
+bool check_zoom() {
+    vector<unsigned char> a(300), b(300), dst(600);
+    for (size_t k = 0; k < a.size(); k++) {
+        a[k] = rand() % 256;
+        b[k] = rand() % 256;
+    }
+
+    for (size_t n = 1; n <= a.size(); n++) {
+        ZoomEvenRow(dst.data(), a.data(), n);
+        for (size_t j = 0; j < 2*n - 1; j++) {
+            unsigned char expected = j % 2 == 0 ? a[j/2] : (a[j/2] + a[j/2+1] + 1) / 2;
+            if (dst[j] != expected)
+                return false;
+        }
+
+        ZoomOddRow(dst.data(), a.data(), b.data(), n);
+        for (size_t j = 0; j < 2*n - 1; j++) {
+            unsigned char expected = j % 2 == 0 ? (a[j/2] + b[j/2] + 1) / 2
+                                                : (a[j/2] + a[j/2+1] + b[j/2] + b[j/2+1] + 2) / 4;
+            if (dst[j] != expected)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// Redondeo de referencia de los núcleos de remuestreo
+unsigned char resample_round(int sum) {
+    int v = (int) floor((sum + (1 << (RESAMPLE_BITS - 1))) / (double) (1 << RESAMPLE_BITS));
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+// Comprueba BlendRows y ResampleRow con pesos aleatorios (también negativos), para
+// todos los números de filas o píxeles combinados hasta 20 y longitudes pequeñas
+bool check_resample() {
+    const size_t N = 100, TAPS = 20;
+    vector<unsigned char> src(N + TAPS), dst(N);
+    vector<vector<unsigned char>> rows(TAPS, vector<unsigned char>(N));
+    vector<short> weights(N * TAPS);
+    vector<ptrdiff_t> first(N);
+
+    for (size_t k = 0; k < src.size(); k++)
+        src[k] = rand() % 256;
+    for (auto & r : rows)
+        for (auto & p : r)
+            p = rand() % 256;
+    for (auto & w : weights)
+        w = rand() % 12000 - 2000;
+    for (size_t j = 0; j < N; j++)
+        first[j] = rand() % TAPS;
+
+    vector<const unsigned char *> pointers;
+    for (auto & r : rows)
+        pointers.push_back(r.data());
+
+    for (size_t taps = 1; taps <= TAPS; taps++)
+        for (size_t n = 0; n <= N; n += 7) {
+            BlendRows(dst.data(), pointers.data(), weights.data(), taps, n);
+            for (size_t j = 0; j < n; j++) {
+                int sum = 0;
+                for (size_t k = 0; k < taps; k++)
+                    sum += weights[k] * rows[k][j];
+                if (dst[j] != resample_round(sum))
+                    return false;
+            }
+
+            ResampleRow(dst.data(), src.data(), n, first.data(), weights.data(), taps);
+            for (size_t j = 0; j < n; j++) {
+                int sum = 0;
+                for (size_t k = 0; k < taps; k++)
+                    sum += weights[j * taps + k] * src[first[j] + k];
+                if (dst[j] != resample_round(sum))
+                    return false;
+            }
+        }
+
+    return true;
+}
+
+// Comprueba TransposeBlock16 con separaciones entre filas distintas en origen y destino
+bool check_transpose() {
+    const ptrdiff_t SRC_STRIDE = 37, DST_STRIDE = 29;
+    vector<unsigned char> src(16 * SRC_STRIDE), dst(16 * DST_STRIDE);
+    for (size_t k = 0; k < src.size(); k++)
+        src[k] = rand() % 256;
+
+    memset(dst.data(), 0, dst.size());
+    TransposeBlock16(dst.data(), DST_STRIDE, src.data(), SRC_STRIDE);
+
+    for (ptrdiff_t i = 0; i < 16; i++)
+        for (ptrdiff_t j = 0; j < DST_STRIDE; j++) {
+            unsigned char expected = j < 16 ? src[j * SRC_STRIDE + i] : 0;
+            if (dst[i * DST_STRIDE + j] != expected)
+                return false;
+        }
+
+    return true;
+}
+
+// Igual que check_invert, para ReverseRow
+bool check_reverse() {
+    vector<unsigned char> src(512), dst(512);
+    for (size_t k = 0; k < src.size(); k++)
+        src[k] = rand() % 256;
+
+    for (size_t offset = 0; offset < 64; offset++)
+        for (size_t n = 0; offset + n <= 300; n++) {
+            memset(dst.data(), 0, dst.size());
+            ReverseRow(dst.data() + offset, src.data() + offset, n);
+
+            for (size_t k = 0; k < dst.size(); k++) {
+                unsigned char expected = (k >= offset && k < offset + n) ? src[2 * offset + n - 1 - k] : 0;
+                if (dst[k] != expected)
+                    return false;
+            }
+        }
+
+    return true;
+}
+
+// Núcleos medidos: todos trabajan in situ sobre el buffer
+void run_invert(unsigned char * buffer, size_t bytes) {
+    InvertRow(buffer, buffer, bytes);
+}
+
+void run_lut(unsigned char * buffer, size_t bytes) {
+    static unsigned char lut[256];
+    for (int v = 0; v < 256; v++)
+        lut[v] = (v * 7) % 256;
+    ApplyLUTRow(buffer, buffer, bytes, lut);
+}
+
+// Acumula el buffer sobre sí mismo: solo cuenta el ancho de banda, no el resultado
+void run_accumulate(unsigned char * buffer, size_t bytes) {
+    AccumulateRow(reinterpret_cast<unsigned short *>(buffer), buffer + bytes / 2, bytes / 2);
+}
+
+// Fila par de Zoom2X: la fila de origen (la mitad de bytes) se reserva una vez por tamaño
+void run_zoom(unsigned char * buffer, size_t bytes) {
+    static vector<unsigned char> row;
+    if (row.size() != bytes / 2)
+        row.assign(bytes / 2, 100);
+    ZoomEvenRow(buffer, row.data(), bytes / 2);
+}
+
+// Pasada vertical con 4 filas (bicúbico al ampliar) que recorren el buffer por cuartos
+void run_resample(unsigned char * buffer, size_t bytes) {
+    const short weights[4] = {-1000, 9000, 9000, -617};
+    const unsigned char * rows[4] = {buffer, buffer + bytes / 4, buffer + bytes / 2, buffer + 3 * (bytes / 4)};
+    BlendRows(buffer, rows, weights, 4, bytes / 4);
+}
+
+// Traspone bloques consecutivos de 16x16 dentro del buffer, como filas de 4096 bytes
+void run_transpose(unsigned char * buffer, size_t bytes) {
+    const ptrdiff_t STRIDE = 4096;
+    for (size_t band = 0; band + 16 * STRIDE <= bytes; band += 16 * STRIDE)
+        for (ptrdiff_t j = 0; j < STRIDE; j += 32)
+            TransposeBlock16(buffer + band + j, STRIDE, buffer + band + j + 16, STRIDE);
+}
+
+// Invierte la segunda mitad del buffer sobre la primera
+void run_reverse(unsigned char * buffer, size_t bytes) {
+    ReverseRow(buffer, buffer + bytes / 2, bytes / 2);
+}
+
+// Devuelve los GB/s procesados (bytes de la imagen por segundo)
+double throughput(void (*kernel)(unsigned char *, size_t), size_t bytes, int repetitions) {
+    vector<unsigned char> buffer(bytes, 100);
+
+    // Calentamiento: lleva el buffer a memoria y a caché antes de medir
+    kernel(buffer.data(), bytes);
+
+    chrono::high_resolution_clock::time_point start_time = chrono::high_resolution_clock::now();
+    for (int k = 0; k < repetitions; ++k)
+        kernel(buffer.data(), bytes);
+    chrono::high_resolution_clock::time_point finish_time = chrono::high_resolution_clock::now();
+
+    chrono::duration<double> total_duration = chrono::duration_cast<chrono::duration<double>>(finish_time - start_time);
+    return (double) bytes * repetitions / total_duration.count() / 1e9;
+}
+
+int main (int argc, char * argv[]) {
+
+    if (argc > 2 || (argc == 2 && strcmp(argv[1], "--check") != 0)) {
+        cerr << "Uso: " << argv[0] << " [--check]" << endl;
+        return 1;
+    }
+
+    const size_t SIZES[] = {64 * 1024, 4 * 1024 * 1024, 64 * 1024 * 1024};
+    const bool check_only = argc == 2;
+    const int REPETITIONS = 20;
+    SimdLevel best = DetectSimdLevel();
+    bool ok = true;
+
+    if (check_only)
+        cout << "Nucleo\tNivel\tCorrecto" << endl;
+    else
+        cout << "Nucleo\tNivel\tCorrecto\tBytes\tGB/s" << endl;
+
+    struct {
+        const char * name;
+        bool (*check)();
+        void (*kernel)(unsigned char *, size_t);
+    } kernels[] = {
+        {"Invert", check_invert, run_invert},
+        {"ApplyLUT", check_lut, run_lut},
+        {"Accumulate", check_accumulate, run_accumulate},
+        {"Zoom2X", check_zoom, run_zoom},
+        {"Resample", check_resample, run_resample},
+        {"Transpose", check_transpose, run_transpose},
+        {"Reverse", check_reverse, run_reverse}
+    };
+
+    for (auto & k : kernels)
+        for (int level = SIMD_SCALAR; level <= best; level++) {
+            SetSimdLevel((SimdLevel) level);
+            bool correct = k.check();
+            ok = ok && correct;
+
+            if (check_only) {
+                cout << k.name << "\t" << SimdLevelName(GetSimdLevel()) << "\t" << (correct ? "si" : "NO") << endl;
+                continue;
+            }
+
+            for (size_t bytes : SIZES)
+                cout << k.name << "\t" << SimdLevelName(GetSimdLevel()) << "\t" << (correct ? "si" : "NO") << "\t"
+                     << bytes << "\t" << throughput(k.kernel, bytes, REPETITIONS) << endl;
+        }
+
+    SetSimdLevel(best);
+    cout << (ok ? "OK" : "ERROR") << endl;
+
+    return ok ? 0 : 1;
+}
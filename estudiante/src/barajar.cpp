@@ -14,21 +14,33 @@ using namespace std;
 int main (int argc, char *argv[]) {
 
     char *origen, *destino; // nombres de los ficheros
+    const char *operacion = "filas";
     Image image;
 
     // Comprobar validez de la llamada
-    if (argc != 3) {
+    if (argc != 3 && argc != 4) {
         cerr << "Error: Numero incorrecto de parametros.\n";
-        cerr << "Uso: negativo <FichImagenOriginal> <FichImagenDestino>\n";
+        cerr << "Uso: barajar [filas|columnas|trasponer|rotar90|rotar180|rotar270] <FichImagenOriginal> <FichImagenDestino>\n";
         exit(1);
     }
 
     // Obtener argumentos
-    origen = argv[1];
-    destino = argv[2];
+    if (argc == 4)
+        operacion = argv[1];
+    origen = argv[argc-2];
+    destino = argv[argc-1];
+
+    if (strcmp(operacion, "filas") != 0 && strcmp(operacion, "columnas") != 0 &&
+        strcmp(operacion, "trasponer") != 0 && strcmp(operacion, "rotar90") != 0 &&
+        strcmp(operacion, "rotar180") != 0 && strcmp(operacion, "rotar270") != 0) {
+        cerr << "Error: Operacion desconocida: " << operacion << endl;
+        cerr << "Uso: barajar [filas|columnas|trasponer|rotar90|rotar180|rotar270] <FichImagenOriginal> <FichImagenDestino>\n";
+        exit(1);
+    }
 
     // Mostramos argumentos
     cout << endl;
+    cout << "Operacion: " << operacion << endl;
     cout << "Fichero origen: " << origen << endl;
     cout << "Fichero resultado: " << destino << endl;
 
@@ -44,7 +56,14 @@ int main (int argc, char *argv[]) {
     cout << "Dimensiones de " << origen << ":" << endl;
     cout << "   Imagen   = " << image.get_rows()  << " filas x " << image.get_cols() << " columnas " << endl;
 
-    image.ShuffleRows();
+    if (strcmp(operacion, "filas") == 0)
+        image.ShuffleRows();
+    else if (strcmp(operacion, "columnas") == 0)
+        image.ShuffleCols();
+    else if (strcmp(operacion, "trasponer") == 0)
+        image = image.Transpose();
+    else
+        image = image.Rotate(atoi(operacion + strlen("rotar")));
 
     // Guardar la imagen resultado en el fichero
     if (image.Save(destino))
@@ -7,6 +7,8 @@
 #include <cstdlib>
 
 #include <image.h>
+#include <imagePipeline.h>
+#include <imageStream.h>
 
 using namespace std;
 
@@ -14,23 +16,55 @@ int main (int argc, char *argv[]){
 
     char *origen, *destino; // nombres de los ficheros
     Image imagen;
-    int e1, e2, s1, s2;  // valores para ajustar el contraste
+    int e1 = 0, e2 = 255, s1 = 0, s2 = 255;  // valores para ajustar el contraste
+    double p1 = 1, p2 = 99;  // percentiles del ajuste automático
 
 
+    // Con --stream la imagen se procesa fila a fila, sin cargarla completa
+    bool stream = argc > 1 && strcmp(argv[1], "--stream") == 0;
+    if (stream){
+        argc--;
+        argv++;
+    }
+
+    // Con --auto los umbrales se calculan a partir del histograma; con --equalize se ecualiza
+    bool automatico = argc > 1 && strcmp(argv[1], "--auto") == 0;
+    bool ecualizar = argc > 1 && strcmp(argv[1], "--equalize") == 0;
+    if (automatico || ecualizar){
+        argc--;
+        argv++;
+    }
+
     // Comprobar validez de la llamada
-    if (argc != 7){
+    bool valida;
+    if (automatico)
+        valida = argc == 3 || argc == 5;
+    else if (ecualizar)
+        valida = argc == 3;
+    else
+        valida = argc == 7;
+
+    if (!valida){
         cerr << "Error: Numero incorrecto de parametros.\n";
-        cerr << "Uso: contraste <FichImagenOriginal> <FichImagenDestino> <e1> <e2> <s1> <s2>\n";
+        cerr << "Uso: contraste [--stream] <FichImagenOriginal> <FichImagenDestino> <e1> <e2> <s1> <s2>\n";
+        cerr << "     contraste [--stream] --auto <FichImagenOriginal> <FichImagenDestino> [<p1> <p2>]\n";
+        cerr << "     contraste [--stream] --equalize <FichImagenOriginal> <FichImagenDestino>\n";
         exit (1);
     }
 
     // Obtener argumentos
     origen  = argv[1];
     destino = argv[2];
-    e1 = stoi(argv[3]);
-    e2 = stoi(argv[4]);
-    s1 = stoi(argv[5]);
-    s2 = stoi(argv[6]);
+    if (automatico && argc == 5){
+        p1 = stod(argv[3]);
+        p2 = stod(argv[4]);
+    }
+    else if (!automatico && !ecualizar){
+        e1 = stoi(argv[3]);
+        e2 = stoi(argv[4]);
+        s1 = stoi(argv[5]);
+        s2 = stoi(argv[6]);
+    }
 
 
     // Mostramos argumentos
@@ -38,8 +72,27 @@ int main (int argc, char *argv[]){
     cout << "Fichero origen: " << origen << endl;
     cout << "Fichero resultado: " << destino << endl;
 
+    if (stream){
+        bool ok;
+        if (automatico)
+            ok = StreamAutoContrast(origen, destino, p1, p2);
+        else if (ecualizar)
+            ok = StreamEqualize(origen, destino);
+        else
+            ok = StreamAdjustContrast(origen, destino, e1, e2, s1, s2);
+
+        if (ok)
+            cout  << "La imagen se guardo en " << destino << endl;
+        else{
+            cerr << "Error: No pudo procesarse la imagen." << endl;
+            cerr << "Terminando la ejecucion del programa." << endl << endl;
+            return 1;
+        }
+        return 0;
+    }
+
     // Leer la imagen del fichero de entrada
-    if (!imagen.Load(origen)){
+    if (!imagen.Load(origen, LOAD_MAP)){
         cerr << "Error: No pudo leerse la imagen." << endl;
         cerr << "Terminando la ejecucion del programa." << endl;
         return 1;
@@ -50,16 +103,40 @@ int main (int argc, char *argv[]){
     cout << "Dimensiones de " << origen << ":" << endl;
     cout << "   Imagen   = " << imagen.get_rows()  << " filas x " << imagen.get_cols() << " columnas " << endl;
 
-    // Mostramos los parámetros para realizar el ajuste
-    cout << endl;
-    cout << "Se introdujeron los siguientes valores para realizar el ajuste de contraste:" << endl;
-    cout << "\t Umbral inferior de la imagen de entrada: " << e1 << endl;
-    cout << "\t Umbral superior de la imagen de entrada: " << e2 << endl;
-    cout << "\t Umbral inferior de la imagen de salida: " << s1 << endl;
-    cout << "\t Umbral superior de la imagen de salida: " << s2 << endl;
-
-    Image newimagen(imagen);
-    newimagen.AdjustContrast(e1, e2, s1, s2);
+    // La tabla se aplica por bloques al guardar, sin copiar la imagen
+    ImagePipeline newimagen(imagen.View());
+
+    if (automatico || ecualizar){
+        ImageHistogram histograma = imagen.Histogram();
+        byte lut[256];
+
+        // Mostramos el histograma de la entrada
+        cout << endl;
+        cout << "Histograma de la imagen de entrada:" << endl;
+        cout << "\t Minimo: " << (int) histograma.Min() << "  Maximo: " << (int) histograma.Max() << endl;
+        cout << "\t Media: " << histograma.Mean() << "  Varianza: " << histograma.Variance() << endl;
+
+        if (automatico){
+            cout << "\t Percentil " << p1 << ": " << (int) histograma.Percentile(p1) << endl;
+            cout << "\t Percentil " << p2 << ": " << (int) histograma.Percentile(p2) << endl;
+            AutoContrastLUT(lut, histograma, p1, p2);
+        }
+        else
+            EqualizeLUT(lut, histograma);
+
+        newimagen.ApplyLUT(lut);
+    }
+    else{
+        // Mostramos los parámetros para realizar el ajuste
+        cout << endl;
+        cout << "Se introdujeron los siguientes valores para realizar el ajuste de contraste:" << endl;
+        cout << "\t Umbral inferior de la imagen de entrada: " << e1 << endl;
+        cout << "\t Umbral superior de la imagen de entrada: " << e2 << endl;
+        cout << "\t Umbral inferior de la imagen de salida: " << s1 << endl;
+        cout << "\t Umbral superior de la imagen de salida: " << s2 << endl;
+
+        newimagen.AdjustContrast(e1, e2, s1, s2);
+    }
 
     // Mostrar los parametros de la Imagen Resultado
     cout << endl;
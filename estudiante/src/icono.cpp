@@ -7,6 +7,7 @@
 #include <cstdlib>
 
 #include <image.h>
+#include <imagePipeline.h>
 
 using namespace std;
 
@@ -34,7 +35,7 @@ int main (int argc, char *argv[]) {
     cout << "Fichero resultado: " << destino << endl;
 
     // Leer la imagen del fichero de entrada
-    if (!image.Load(origen)){
+    if (!image.Load(origen, LOAD_MAP)){
         cerr << "Error: No pudo leerse la imagen." << endl;
         cerr << "Terminando la ejecucion del programa." << endl;
         return 1;
@@ -49,7 +50,9 @@ int main (int argc, char *argv[]) {
     cout << endl;
     cout << "El valor del factor es: " << factor << endl;
 
-    Image newimage = image.Subsample(factor);
+    // La reducción se calcula por bloques al guardar, sin construir la imagen resultado
+    ImagePipeline newimage(image.View());
+    newimage.Subsample(factor);
 
     // Mostrar los parametros de la Imagen Resultado
     cout << endl;
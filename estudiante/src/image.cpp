@@ -8,9 +8,15 @@
 #include <cassert>
 #include <iostream>
 #include <cmath>
+#include <utility>
+#include <vector>
 
 #include <image.h>
 #include <imageIO.h>
+#include <imageMemory.h>
+#include <imageThreads.h>
+#include <imageTrace.h>
+#include <imageTransform.h>
 
 using namespace std;
 
@@ -18,25 +24,22 @@ using namespace std;
       FUNCIONES PRIVADAS
 ********************************/
 
-void Image::Allocate(int nrows, int ncols, byte * buffer){
+void Image::Allocate(ptrdiff_t nrows, ptrdiff_t ncols, byte * buffer){
     rows = nrows;
     cols = ncols;
 
-    img = new byte*[rows];
-
-    for (int i=0; i < rows; i++){
-        img[i] = new byte [cols];
-
-        if (buffer != 0)
-            for(int j = 0; j < cols; j++)
-                img[i][j] = buffer[i*rows + j];
-    }
-
+    // Una sola reserva para toda la imagen
+    img = AllocateBuffer(size(), "Image::Allocate");
 
+    if (buffer != 0)
+        memcpy(img, buffer, size());
 }
 
 // Función auxiliar para inicializar imágenes con valores por defecto o a partir de un buffer de datos
-void Image::Initialize (int nrows, int ncols, byte * buffer){
+void Image::Initialize (ptrdiff_t nrows, ptrdiff_t ncols, byte * buffer){
+    index_valid.store(false, memory_order_relaxed);
+    mapping.base = 0;
+    mapping.length = 0;
     if ((nrows == 0) || (ncols == 0)){
         rows = cols = 0;
         img = 0;
@@ -47,9 +50,7 @@ void Image::Initialize (int nrows, int ncols, byte * buffer){
 // Función auxiliar para copiar objetos Imagen
 
 void Image::Copy(const Image & orig){
-    Initialize(orig.rows,orig.cols);
-    for (int k=0; k<rows*cols;k++)
-        set_pixel(k,orig.get_pixel(k));
+    Initialize(orig.rows, orig.cols, orig.img);
 }
 
 // Función auxiliar para destruir objetos Imagen
@@ -58,25 +59,126 @@ bool Image::Empty() const{
 }
 
 void Image::Destroy(){
-    if (!Empty()){
-        for (int i = 0; i < get_rows(); i++)
-            delete [] img[i];
-        delete [] img;
-    }
+    if (mapping.base)
+        UnmapPGMImage(mapping);
+    else
+        ReleaseBuffer(img);
+    rows = cols = 0;
+    img = 0;
+    index.Clear();
+    index_valid.store(false, memory_order_relaxed);
+}
+
+void Image::Adopt(byte * buffer, ptrdiff_t nrows, ptrdiff_t ncols){
+    Destroy();
+    rows = nrows;
+    cols = ncols;
+    img = buffer;
 }
 
-LoadResult Image::LoadFromPGM(const char * file_path){
+LoadResult Image::LoadFromPGM(const char * file_path, LoadMode mode){
     if (ReadImageKind(file_path) != IMG_PGM)
         return LoadResult::NOT_PGM;
 
-    byte * buffer = ReadPGMImage(file_path, rows, cols);
+    ptrdiff_t nrows, ncols;
+
+    if (mode == LOAD_MAP){
+        PGMMapping map;
+        byte * pixels = MapPGMImage(file_path, nrows, ncols, map);
+
+        if (pixels){
+            Destroy();
+            rows = nrows;
+            cols = ncols;
+            img = pixels;
+            mapping = map;
+            return LoadResult::SUCCESS;
+        }
+    }
+
+    byte * buffer = ReadPGMImage(file_path, nrows, ncols);
     if (!buffer)
         return LoadResult::READING_ERROR;
 
-    Initialize(rows, cols, buffer);
+    // El buffer leído ya tiene el formato de la representación: la imagen se queda con él sin copiarlo
+    Adopt(buffer, nrows, ncols);
     return LoadResult::SUCCESS;
 }
 
+// Máximo común divisor
+static ptrdiff_t Gcd(ptrdiff_t a, ptrdiff_t b){
+    while (b != 0){
+        ptrdiff_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+// (a * b) % n sin desbordamiento, con 0 <= a, b < n
+static ptrdiff_t MulMod(ptrdiff_t a, ptrdiff_t b, ptrdiff_t n){
+    return (ptrdiff_t) ((unsigned __int128) a * b % n);
+}
+
+// Inverso de a módulo n por el algoritmo de Euclides extendido
+// Precondición: mcd(a, n) = 1
+static ptrdiff_t InverseMod(ptrdiff_t a, ptrdiff_t n){
+    ptrdiff_t r0 = n, r1 = a, t0 = 0, t1 = 1;
+
+    while (r1 != 0){
+        ptrdiff_t q = r0 / r1, tmp;
+        tmp = r0 - q*r1; r0 = r1; r1 = tmp;
+        tmp = t0 - q*t1; t0 = t1; t1 = tmp;
+    }
+    return t0 < 0 ? t0 + n : t0;
+}
+
+// Con i*P % n no biyectiva varias filas reciben la misma fila de origen y no se puede
+// trabajar en el sitio: se copian a un buffer nuevo
+void Image::ShuffleRowsCopy(ptrdiff_t P){
+    byte * newimage = AllocateBuffer(size(), "Image::ShuffleRows");
+
+    for (ptrdiff_t i = 0; i < rows; i++)
+        memcpy(newimage + i*cols, img + MulMod(i, P % rows, rows)*cols, cols);
+
+    Adopt(newimage, rows, cols);
+}
+
+/*
+  Cada ciclo s -> perm(s) -> perm(perm(s)) ... se recorre una vez: se guarda la fila s, cada
+  fila j recibe la fila perm(j), y la última del ciclo recibe la guardada. Un bit por fila
+  marca las que ya están en su sitio, y basta un buffer de una fila.
+*/
+template <typename Perm>
+void Image::PermuteRowsWith(Perm perm){
+    if (rows <= 1)
+        return;
+
+    index_valid.store(false, memory_order_relaxed);
+
+    vector<bool> placed(rows);
+    vector<byte> saved(cols);
+
+    for (ptrdiff_t s = 0; s < rows; s++){
+        if (placed[s])
+            continue;
+
+        placed[s] = true;
+        ptrdiff_t j = s, next = perm(s);
+        if (next == s)
+            continue;
+
+        memcpy(saved.data(), img + s*cols, cols);
+        while (next != s){
+            memcpy(img + j*cols, img + next*cols, cols);
+            placed[next] = true;
+            j = next;
+            next = perm(j);
+        }
+        memcpy(img + j*cols, saved.data(), cols);
+    }
+}
+
 /********************************
        FUNCIONES PÚBLICAS
 ********************************/
@@ -88,23 +190,52 @@ Image::Image(){
 }
 
 // Constructores con parámetros
-Image::Image (int nrows, int ncols, byte value){
+Image::Image (ptrdiff_t nrows, ptrdiff_t ncols, byte value){
     Initialize(nrows, ncols);
-    for (int k=0; k<rows*cols; k++)set_pixel(k, value);
+    if (!Empty())
+        memset(img, value, size());
 }
 
-bool Image::Load (const char * file_path) {
+bool Image::Load (const char * file_path, LoadMode mode) {
+    IMAGE_TRACE_SCOPE("Image::Load");
     Destroy();
-    return LoadFromPGM(file_path) == LoadResult::SUCCESS;
+    return LoadFromPGM(file_path, mode) == LoadResult::SUCCESS;
 }
 
 // Constructor de copias
 
 Image::Image (const Image & orig){
+    IMAGE_TRACE_SCOPE("Image::Image(const Image &)");
     assert (this != &orig);
     Copy(orig);
 }
 
+// Constructor a partir de una vista: una única reserva y una copia por fila
+
+Image::Image (const ImageView & view){
+    IMAGE_TRACE_SCOPE("Image::Image(const ImageView &)");
+    Initialize(view.get_rows(), view.get_cols());
+    ParallelFor(rows, RowGrain(cols), [&](ptrdiff_t begin, ptrdiff_t end){
+        for (ptrdiff_t i = begin; i < end; i++)
+            memcpy(img + i*cols, view.row(i), cols);
+    });
+}
+
+// Constructor de movimiento
+
+Image::Image (Image && orig) noexcept{
+    rows = orig.rows;
+    cols = orig.cols;
+    img = orig.img;
+    mapping = orig.mapping;
+
+    orig.rows = orig.cols = 0;
+    orig.img = 0;
+    orig.mapping.base = 0;
+    orig.mapping.length = 0;
+    index_valid.store(false, memory_order_relaxed);
+}
+
 // Destructor
 
 Image::~Image(){
@@ -114,6 +245,7 @@ Image::~Image(){
 // Operador de Asignación
 
 Image & Image::operator= (const Image & orig){
+    IMAGE_TRACE_SCOPE("Image::operator=");
     if (this != &orig){
         Destroy();
         Copy(orig);
@@ -121,216 +253,245 @@ Image & Image::operator= (const Image & orig){
     return *this;
 }
 
+// Operador de asignación por movimiento
+
+Image & Image::operator= (Image && orig) noexcept{
+    if (this != &orig){
+        Destroy();
+        swap(orig);
+    }
+    return *this;
+}
+
+void Image::swap (Image & other) noexcept{
+    std::swap(rows, other.rows);
+    std::swap(cols, other.cols);
+    std::swap(img, other.img);
+    std::swap(mapping, other.mapping);
+    index.swap(other.index);
+    bool valid = index_valid.load(memory_order_relaxed);
+    index_valid.store(other.index_valid.load(memory_order_relaxed), memory_order_relaxed);
+    other.index_valid.store(valid, memory_order_relaxed);
+}
+
+// Vistas sobre la imagen completa
+
+ImageView Image::View() const {
+    return ImageView(img, rows, cols, cols);
+}
+
+MutableImageView Image::MutableView() {
+    index_valid.store(false, memory_order_relaxed);
+    return MutableImageView(img, rows, cols, cols);
+}
+
+// Imagen integral, construida bajo demanda. Si varios hilos la piden a la vez, el primero que
+// coge el cerrojo la construye y el resto la encuentran ya válida
+
+const IntegralImage & Image::get_integral() const {
+    if (!index_valid.load(memory_order_acquire)){
+        lock_guard<mutex> guard(index_lock);
+        if (!index_valid.load(memory_order_relaxed)){
+            IMAGE_TRACE_SCOPE("IntegralImage::Build");
+            index.Build(View());
+            index_valid.store(true, memory_order_release);
+        }
+    }
+    return index;
+}
+
 // Métodos de acceso a los campos de la clase
 
-int Image::get_rows() const {
+ptrdiff_t Image::get_rows() const {
     return rows;
 }
 
-int Image::get_cols() const {
+ptrdiff_t Image::get_cols() const {
     return cols;
 }
 
-int Image::size() const{
+size_t Image::size() const{
     return get_rows()*get_cols();
 }
 
 // Métodos básicos de edición de imágenes
-void Image::set_pixel (int i, int j, byte value) {
-    img[i][j] = value;
+void Image::set_pixel (ptrdiff_t i, ptrdiff_t j, byte value) {
+    index_valid.store(false, memory_order_relaxed);
+    img[i*cols + j] = value;
 }
-byte Image::get_pixel (int i, int j) const {
-    return img[i][j];
+byte Image::get_pixel (ptrdiff_t i, ptrdiff_t j) const {
+    return img[i*cols + j];
 }
 
-// This doesn't work if representation changes
-void Image::set_pixel (int k, byte value) {
-    int fils = k/get_cols();
-    int cols = k%get_cols();
-    set_pixel(fils, cols, value);
+// Al ser el buffer contiguo, el índice desenrollado es directamente el desplazamiento
+void Image::set_pixel (ptrdiff_t k, byte value) {
+    index_valid.store(false, memory_order_relaxed);
+    img[k] = value;
 }
 
-// This doesn't work if representation changes
-byte Image::get_pixel (int k) const {
-    int fils = k/get_cols();
-    int cols = k%get_cols();
-    return get_pixel(fils, cols);
+byte Image::get_pixel (ptrdiff_t k) const {
+    return img[k];
 }
 
 // Métodos para almacenar y cargar imagenes en disco
-bool Image::Save (const char * file_path) const {
-    int nrows = get_rows();
-    int ncols = get_cols();
-    byte * p = new byte [nrows*ncols];
-
-    for (int i = 0; i < nrows; i++)
-        for (int j = 0; j < ncols; j++)
-            p[i*ncols + j] = get_pixel(i,j);
-
-    return WritePGMImage(file_path, p, rows, cols);
+bool Image::Save (const char * file_path, unsigned mode) const {
+    IMAGE_TRACE_SCOPE("Image::Save");
+    // El buffer ya está en el orden del fichero: se escribe directamente
+    return View().Save(file_path, mode);
 }
 // Método para obtener una imagen con la tonalidad invertida
 void Image::Invert(void) {
-    for (int i=0; i<size(); i++)
-        set_pixel(i,255-get_pixel(i));
+    IMAGE_TRACE_SCOPE("Image::Invert");
+    MutableView().Invert();
 }
 // Método para obtener una subimagen
-Image Image::Crop(int nrow, int ncol, int height, int width) const {
+ImageView Image::Crop(ptrdiff_t nrow, ptrdiff_t ncol, ptrdiff_t height, ptrdiff_t width) const {
+    IMAGE_TRACE_SCOPE("Image::Crop");
+    return View().Crop(nrow, ncol, height, width);
+}
 
-    if(ncol>= get_cols() || nrow>= get_rows() || height<=0 || width<=0){
-        width = 0;
-        height = 0;
-    }
+// Método para obtener una imagen aumentada al doble de su tamaño
+Image Image::Zoom2X(void) const {
+    IMAGE_TRACE_SCOPE("Image::Zoom2X");
+    return View().Zoom2X();
+}
 
-    else{
-        if(width+ncol> get_cols())
-            width = get_cols()-ncol;
+// Método para obtener una imagen escalada a cualquier tamaño
+Image Image::Resize(ptrdiff_t new_rows, ptrdiff_t new_cols, ResizeFilter filter) const {
+    IMAGE_TRACE_SCOPE("Image::Resize");
+    return View().Resize(new_rows, new_cols, filter);
+}
 
-        if(height+nrow> get_rows())
-            height = get_rows()-nrow;
-    }
+// Método para obtener una imagen con tamaño reducido
+Image Image::Subsample(ptrdiff_t factor) const {
+    IMAGE_TRACE_SCOPE("Image::Subsample");
+    return View().Subsample(factor);
+}
 
-    Image newimage (height, width);
-    for(int i= 0; i < height; i++){
+// Método para aplicar una operación puntual mediante una tabla de consulta
+void Image::ApplyLUT(const byte lut[256]) {
+    IMAGE_TRACE_SCOPE("Image::ApplyLUT");
+    MutableView().ApplyLUT(lut);
+}
 
-        for(int j=0; j < width; j++){
+// Método para obtener una imagen con nuevo contraste
+void Image::AdjustContrast(byte in1, byte in2, byte out1, byte out2) {
+    IMAGE_TRACE_SCOPE("Image::AdjustContrast");
+    MutableView().AdjustContrast(in1, in2, out1, out2);
+}
 
-            newimage.set_pixel(i, j, get_pixel(i+nrow,j+ncol));
-        }
-    }
+// Método para ajustar el contraste a partir del histograma
+void Image::AutoContrast(double low, double high) {
+    IMAGE_TRACE_SCOPE("Image::AutoContrast");
+    MutableView().AutoContrast(low, high);
+}
 
-    return newimage;
+// Método para ecualizar el histograma
+void Image::Equalize() {
+    IMAGE_TRACE_SCOPE("Image::Equalize");
+    MutableView().Equalize();
 }
 
-// Método para obtener una imagen aumentada al doble de su tamaño
-Image Image::Zoom2X(void) const {
+// Método para calcular el valor medio de los píxeles de una imagen
+double Image::Mean(ptrdiff_t i, ptrdiff_t j, ptrdiff_t height, ptrdiff_t width) const{
+    IMAGE_TRACE_SCOPE("Image::Mean");
+    // Sin la imagen integral construida, sumar el fragmento cuesta menos que construirla
+    if (index_valid.load(memory_order_acquire))
+        return index.Mean(i, j, height, width);
+    return View().Mean(i, j, height, width);
+}
 
-    int newheight = get_rows()*2-1;
-    int newwidth = get_cols()*2-1;
-    Image newimage(newheight, newwidth);
-    byte valor_aux=0;
-
-    //Asignación de pixeles
-
-    for(int i = 0; i < newheight; i++){
-        for(int j = 0; j < newwidth; j++){
-
-            if(i%2 == 0) {
-                if (j%2 == 0)
-                    newimage.set_pixel(i, j, get_pixel(i/2, j/2));   //Filas y columnas pares
-
-                else{
-                    valor_aux= lround((get_pixel(i/2,j/2) + get_pixel(i/2,j/2+1))/2.0 );
-                    newimage.set_pixel(i, j, valor_aux); //Interpolación
-                }
-            }
-
-            else{
-                if (j%2 == 0){
-                    valor_aux= lround((get_pixel(i/2,j/2) + get_pixel(i/2+1,j/2))/2.0 );
-                    newimage.set_pixel(i, j, valor_aux); //Interpolación
-                }
-
-                else{
-                    valor_aux= lround((get_pixel(i/2,j/2) + get_pixel(i/2,j/2+1) + get_pixel(i/2+1,j/2) + get_pixel(i/2+1,j/2+1))/4.0 );
-                    newimage.set_pixel(i, j, valor_aux);
-                }
-            }
-        }
+// Método para obtener el histograma de la imagen
+ImageHistogram Image::Histogram() const{
+    IMAGE_TRACE_SCOPE("Image::Histogram");
+    return View().Histogram();
+}
 
-    }
+// Método que baraja las filas de una imagen pseudoaleatoriamente
+// Las filas se mueven en su sitio siguiendo los ciclos de la permutación
+void Image::ShuffleRows(ptrdiff_t P) {
+    IMAGE_TRACE_SCOPE("Image::ShuffleRows");
+    ptrdiff_t n = get_rows();
 
-    return newimage;
-}
+    if (n <= 1)
+        return;
 
-// Método para obtener una imagen con tamaño reducido
-Image Image::Subsample(int factor) const {
+    if (Gcd(P % n, n) != 1){
+        ShuffleRowsCopy(P);
+        return;
+    }
 
-    if (factor > (int)get_rows()) factor = get_rows();
-    int newheight = lround(get_rows()/factor);
-    int newwidth = lround(get_cols()/factor);
-    Image newimage (newheight,newwidth);
-    byte valor_aux;
-    double total = 0;
+    P %= n;
+    PermuteRowsWith([P, n](ptrdiff_t i){ return MulMod(i, P, n); });
+}
 
-    //Asignación de pixeles
-    for(int i = 0; i < newheight; i++){
-        for(int j = 0; j < newwidth; j++){
+// La inversa de i -> i*P % n es i -> i*Q % n, siendo Q el inverso de P módulo n. Sin
+// inverso no hay permutación que seguir: los ciclos no se cerrarían
+bool Image::UnshuffleRows(ptrdiff_t P) {
+    IMAGE_TRACE_SCOPE("Image::UnshuffleRows");
+    ptrdiff_t n = get_rows();
 
-            total= Mean(i*factor,j*factor,factor,factor);
-            valor_aux= lround(total);
-            newimage.set_pixel(i,j,valor_aux);
+    if (n <= 1)
+        return true;
 
-        }
+    if (Gcd(P % n, n) != 1)
+        return false;
 
-    }
+    ptrdiff_t Q = InverseMod(P % n, n);
+    PermuteRowsWith([Q, n](ptrdiff_t i){ return MulMod(i, Q, n); });
+    return true;
+}
 
-    return newimage;
+void Image::PermuteRows(const ptrdiff_t * perm) {
+    IMAGE_TRACE_SCOPE("Image::PermuteRows");
+    PermuteRowsWith([perm](ptrdiff_t i){ return perm[i]; });
 }
 
-// Método para obtener una imagen con nuevo contraste
-void Image::AdjustContrast(byte in1, byte in2, byte out1, byte out2) {
-    double quotient1 ;
-    if (in1!=0) quotient1= (double)out1 / (double)in1;
-    else quotient1=0;
+// Las columnas se reordenan fila a fila con una tabla: aunque P no sea coprimo con el
+// número de columnas, cada fila se recompone a partir de una copia
+void Image::ShuffleCols(ptrdiff_t P) {
+    IMAGE_TRACE_SCOPE("Image::ShuffleCols");
+    if (cols <= 1)
+        return;
 
-    double quotient2 = (double)(out2 - out1) / (double)(in2 - in1);
+    vector<ptrdiff_t> perm(cols);
+    for (ptrdiff_t j = 0; j < cols; j++)
+        perm[j] = MulMod(j, P % cols, cols);
 
-    double quotient3;
-    if (in2!=255) quotient3= (double)(255 - out2) / (double)(255 - in2);
-    else quotient3=0;
+    PermuteColumns(MutableView(), perm.data());
+}
 
-    byte new_byte=0;
+bool Image::UnshuffleCols(ptrdiff_t P) {
+    IMAGE_TRACE_SCOPE("Image::UnshuffleCols");
+    if (cols <= 1)
+        return true;
 
-    for(int k = 0; k < get_rows()*get_cols(); k++){
+    if (Gcd(P % cols, cols) != 1)
+        return false;
 
-        if(get_pixel(k) >= 0 && get_pixel(k) < in1){
-            new_byte = lround(quotient1 * get_pixel(k));
-        }
-        else{
-            if(get_pixel(k) >= in1 && get_pixel(k) <= in2){
-                new_byte = lround(out1 + (quotient2 * (get_pixel(k) - in1)));
-            }
-            else{
-                new_byte = lround(out2 + (quotient3 * (get_pixel(k) - in2)));
-            }
-        }
-        set_pixel(k, new_byte);
+    ptrdiff_t Q = InverseMod(P % cols, cols);
+    vector<ptrdiff_t> perm(cols);
+    for (ptrdiff_t j = 0; j < cols; j++)
+        perm[j] = MulMod(j, Q, cols);
 
-    }
+    PermuteColumns(MutableView(), perm.data());
+    return true;
 }
 
-// Método para calcular el valor medio de los píxeles de una imagen
-double Image::Mean(int i, int j, int height, int width) const{
-    Image frag=Crop(i, j, height, width);
-    double sum = 0, niter=0;
-
-    for(int f = 0; f < frag.get_rows(); f++){
-        for (int c = 0; c < frag.get_cols(); c++){
-            sum += frag.get_pixel(f, c);
-            niter++;
-        }
-    }
-
-    double mean = sum / niter;
-    return mean;
+void Image::PermuteCols(const ptrdiff_t * perm) {
+    IMAGE_TRACE_SCOPE("Image::PermuteCols");
+    PermuteColumns(MutableView(), perm);
 }
 
-// Método que baraja las filas de una imagen pseudoaleatoriamente
-void Image::ShuffleRows(void) {
-    const int P = 9973;
-    int fils = get_rows();
-    int cols = get_cols();
-    byte ** newimage = new byte * [fils];
-    int newfil;
-
-    for (int i = 0; i < fils; i++){
-        newfil = i*P % fils;
-        newimage[i]=img[newfil];
-    }
-
-   for (int i = 0; i < fils; i++)
-       img[i]=newimage[i];
+// Método para obtener la imagen traspuesta
+Image Image::Transpose() const {
+    IMAGE_TRACE_SCOPE("Image::Transpose");
+    return View().Transpose();
+}
 
+// Método para obtener la imagen girada
+Image Image::Rotate(int degrees) const {
+    IMAGE_TRACE_SCOPE("Image::Rotate");
+    return View().Rotate(degrees);
 }
 
@@ -0,0 +1,138 @@
+/**
+  * @file imageCounters.cpp
+  * @brief Fichero con definiciones para la lectura de contadores hardware del procesador
+  *
+  */
+
+#include <cstring>
+
+#include <imageCounters.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const char *NAMES[COUNTER_EVENTS]= {
+  "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "dtlb_misses"
+};
+
+const char * CounterName (CounterEvent event){
+  return NAMES[event];
+}
+
+#ifdef __linux__
+
+// Tipo y configuración de perf_event_attr de cada evento
+static void Describe (CounterEvent event, unsigned& type, unsigned long long& config){
+  const unsigned long long READ_MISS= (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  switch (event){
+    case COUNTER_CYCLES:
+      type= PERF_TYPE_HARDWARE; config= PERF_COUNT_HW_CPU_CYCLES; break;
+    case COUNTER_INSTRUCTIONS:
+      type= PERF_TYPE_HARDWARE; config= PERF_COUNT_HW_INSTRUCTIONS; break;
+    case COUNTER_L1D_MISSES:
+      type= PERF_TYPE_HW_CACHE; config= PERF_COUNT_HW_CACHE_L1D | READ_MISS; break;
+    case COUNTER_LLC_MISSES:
+      type= PERF_TYPE_HARDWARE; config= PERF_COUNT_HW_CACHE_MISSES; break;
+    case COUNTER_BRANCH_MISSES:
+      type= PERF_TYPE_HARDWARE; config= PERF_COUNT_HW_BRANCH_MISSES; break;
+    default:
+      type= PERF_TYPE_HW_CACHE; config= PERF_COUNT_HW_CACHE_DTLB | READ_MISS; break;
+  }
+}
+
+// Solo modo usuario: con perf_event_paranoid = 2 (el valor habitual) no se permite más
+static int Open (CounterEvent event){
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size= sizeof(attr);
+  Describe(event, attr.type, attr.config);
+  attr.disabled= 1;
+  attr.exclude_kernel= 1;
+  attr.exclude_hv= 1;
+  attr.read_format= PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+PerfCounters::PerfCounters (){
+  for (int e=0; e<COUNTER_EVENTS; e++){
+    fd[e]= Open((CounterEvent) e);
+    values[e]= 0;
+  }
+}
+
+PerfCounters::~PerfCounters (){
+  for (int e=0; e<COUNTER_EVENTS; e++)
+    if (fd[e] >= 0)
+      close(fd[e]);
+}
+
+void PerfCounters::Start (){
+  for (int e=0; e<COUNTER_EVENTS; e++)
+    if (fd[e] >= 0){
+      ioctl(fd[e], PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd[e], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+// Si el evento solo estuvo activo parte del intervalo se escala al intervalo completo
+void PerfCounters::Stop (){
+  for (int e=0; e<COUNTER_EVENTS; e++)
+    if (fd[e] >= 0)
+      ioctl(fd[e], PERF_EVENT_IOC_DISABLE, 0);
+
+  for (int e=0; e<COUNTER_EVENTS; e++){
+    unsigned long long data[3];   // valor, tiempo activo, tiempo contando
+    values[e]= 0;
+
+    if (fd[e] < 0 || read(fd[e], data, sizeof(data)) != sizeof(data) || data[2] == 0)
+      continue;
+
+    values[e]= data[1] == data[2] ? data[0]
+                                  : (unsigned long long) ((double) data[0] * data[1] / data[2]);
+  }
+}
+
+#else
+
+// Sin perf_event_open no hay contadores: todas las mediciones quedan a cero
+
+PerfCounters::PerfCounters (){
+  for (int e=0; e<COUNTER_EVENTS; e++){
+    fd[e]= -1;
+    values[e]= 0;
+  }
+}
+
+PerfCounters::~PerfCounters (){
+}
+
+void PerfCounters::Start (){
+}
+
+void PerfCounters::Stop (){
+}
+
+#endif
+
+bool PerfCounters::Available () const{
+  for (int e=0; e<COUNTER_EVENTS; e++)
+    if (fd[e] >= 0)
+      return true;
+  return false;
+}
+
+bool PerfCounters::Available (CounterEvent event) const{
+  return fd[event] >= 0;
+}
+
+unsigned long long PerfCounters::Value (CounterEvent event) const{
+  return values[event];
+}
+
+/* Fin Fichero: imageCounters.cpp */
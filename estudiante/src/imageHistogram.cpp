@@ -0,0 +1,226 @@
+/**
+ * @file imageHistogram.cpp
+ * @brief Fichero con definiciones para los métodos de la clase ImageHistogram
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+
+#include <imageHistogram.h>
+#include <imageThreads.h>
+
+using namespace std;
+
+// Píxeles que se cuentan en los contadores de 32 bits antes de volcarlos a los de 64:
+// cada subhistograma recibe como mucho la mitad, que no desborda
+static const ptrdiff_t FLUSH_PIXELS = ptrdiff_t(1) << 30;
+
+// Suma n píxeles a cuatro subhistogramas. Contar píxeles seguidos del mismo valor en un
+// único contador encadena cada incremento con el anterior (lectura tras escritura en la
+// misma posición); repartiéndolos entre cuatro tablas los incrementos son independientes.
+// Los píxeles se leen de 8 en 8 con una sola carga de 64 bits.
+static void CountPixels(unsigned int sub[4][256], const byte * p, ptrdiff_t n){
+    ptrdiff_t k = 0;
+
+    for (; k + 8 <= n; k += 8){
+        unsigned long long w;
+        memcpy(&w, p + k, 8);
+
+        sub[0][w & 0xFF]++;
+        sub[1][(w >> 8) & 0xFF]++;
+        sub[2][(w >> 16) & 0xFF]++;
+        sub[3][(w >> 24) & 0xFF]++;
+        sub[0][(w >> 32) & 0xFF]++;
+        sub[1][(w >> 40) & 0xFF]++;
+        sub[2][(w >> 48) & 0xFF]++;
+        sub[3][w >> 56]++;
+    }
+
+    for (; k < n; k++)
+        sub[k % 4][p[k]]++;
+}
+
+// Vuelca los subhistogramas en los contadores de 64 bits y los deja a cero
+static void Flush(unsigned long long counts[256], unsigned int sub[4][256]){
+    for (int v = 0; v < 256; v++)
+        counts[v] += (unsigned long long) sub[0][v] + sub[1][v] + sub[2][v] + sub[3][v];
+
+    memset(sub, 0, 4 * 256 * sizeof(unsigned int));
+}
+
+/********************************
+      FUNCIONES PRIVADAS
+********************************/
+
+// Un único recorrido de los 256 niveles para el acumulado, la suma y los extremos;
+// la varianza se calcula después respecto a la media, que es más estable
+void ImageHistogram::Summarize(){
+    unsigned long long running = 0;
+    double sum = 0;
+
+    lowest = 255;
+    highest = 0;
+
+    for (int v = 0; v < 256; v++){
+        if (bins[v] > 0){
+            lowest = min<int>(lowest, v);
+            highest = v;
+        }
+        running += bins[v];
+        cumulative[v] = running;
+        sum += (double) bins[v] * v;
+    }
+    total = running;
+
+    if (total == 0){
+        lowest = highest = 0;
+        mean = variance = 0;
+        return;
+    }
+
+    mean = sum / total;
+
+    double squares = 0;
+    for (int v = lowest; v <= highest; v++)
+        squares += bins[v] * (v - mean) * (v - mean);
+    variance = squares / total;
+}
+
+/********************************
+       FUNCIONES PÚBLICAS
+********************************/
+
+ImageHistogram::ImageHistogram(){
+    memset(bins, 0, sizeof(bins));
+    Summarize();
+}
+
+ImageHistogram::ImageHistogram(const ImageView & view){
+    Build(view);
+}
+
+void ImageHistogram::Build(const ImageView & view){
+    memset(bins, 0, sizeof(bins));
+    Add(view);
+}
+
+// Cada banda cuenta sus filas en subhistogramas propios y los suma al total al terminar;
+// la suma de enteros no depende del orden, así que el resultado es el mismo con cualquier
+// número de hilos
+void ImageHistogram::Add(const ImageView & view){
+    mutex merge;
+
+    ParallelFor(view.get_rows(), RowGrain(view.get_cols()), [&](ptrdiff_t begin, ptrdiff_t end){
+        unsigned int sub[4][256];
+        unsigned long long counts[256];
+        ptrdiff_t pending = 0;
+
+        memset(sub, 0, sizeof(sub));
+        memset(counts, 0, sizeof(counts));
+
+        for (ptrdiff_t i = begin; i < end; i++){
+            const byte * p = view.row(i);
+
+            for (ptrdiff_t j = 0; j < view.get_cols(); ){
+                ptrdiff_t n = min(view.get_cols() - j, FLUSH_PIXELS - pending);
+                CountPixels(sub, p + j, n);
+                j += n;
+                pending += n;
+
+                if (pending == FLUSH_PIXELS){
+                    Flush(counts, sub);
+                    pending = 0;
+                }
+            }
+        }
+        Flush(counts, sub);
+
+        lock_guard<mutex> guard(merge);
+        for (int v = 0; v < 256; v++)
+            bins[v] += counts[v];
+    });
+
+    Summarize();
+}
+
+unsigned long long ImageHistogram::operator[](byte value) const{
+    return bins[value];
+}
+
+unsigned long long ImageHistogram::Cumulative(byte value) const{
+    return cumulative[value];
+}
+
+unsigned long long ImageHistogram::get_total() const{
+    return total;
+}
+
+bool ImageHistogram::Empty() const{
+    return total == 0;
+}
+
+byte ImageHistogram::Min() const{
+    return lowest;
+}
+
+byte ImageHistogram::Max() const{
+    return highest;
+}
+
+// Primer nivel cuyo acumulado alcanza el número de píxeles pedido (al menos uno)
+byte ImageHistogram::Percentile(double percent) const{
+    if (total == 0)
+        return 0;
+
+    percent = max(0.0, min(100.0, percent));
+    unsigned long long needed = (unsigned long long) ceil(percent / 100 * total);
+    needed = max<unsigned long long>(needed, 1);
+
+    return lower_bound(cumulative, cumulative + 256, needed) - cumulative;
+}
+
+double ImageHistogram::Mean() const{
+    return mean;
+}
+
+double ImageHistogram::Variance() const{
+    return variance;
+}
+
+/********************************
+      TABLAS DE CONSULTA
+********************************/
+
+void AutoContrastLUT(byte lut[256], const ImageHistogram & hist, double low, double high){
+    byte in1 = hist.Percentile(low);
+    byte in2 = hist.Percentile(high);
+
+    if (in1 >= in2){
+        for (int v = 0; v < 256; v++)
+            lut[v] = v;
+        return;
+    }
+
+    ContrastLUT(lut, in1, in2, 0, 255);
+}
+
+// Los niveles por debajo del mínimo no aparecen en la imagen: se llevan a 0 igual que él.
+// El redondeo es entero para que la tabla no dependa de la precisión de los double.
+void EqualizeLUT(byte lut[256], const ImageHistogram & hist){
+    unsigned long long first = hist.Empty() ? 0 : hist.Cumulative(hist.Min());
+    unsigned long long range = hist.get_total() - first;
+
+    for (int v = 0; v < 256; v++){
+        if (range == 0)
+            lut[v] = v;
+        else if (hist.Cumulative(v) <= first)
+            lut[v] = 0;
+        else
+            lut[v] = ((hist.Cumulative(v) - first) * 510 + range) / (2 * range);
+    }
+}
+
+/* Fin Fichero: imageHistogram.cpp */
@@ -7,8 +7,25 @@
   */
 
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 #include <imageIO.h>
+#include <imageMemory.h>
+#include <imageTrace.h>
 
 #include <fstream>
 using namespace std;
@@ -52,14 +69,21 @@ char SkipWhitespaces (ifstream& f){
 
 // _____________________________________________________________________________
 
-bool ReadHeader (ifstream& f, int& rows, int& cols){
+// No hay límite de tamaño, salvo que el número de píxeles debe poder indexarse
+bool ValidDimensions (ptrdiff_t rows, ptrdiff_t cols){
+  return rows>0 && cols>0 && cols <= PTRDIFF_MAX / rows;
+}
+
+// _____________________________________________________________________________
+
+bool ReadHeader (ifstream& f, ptrdiff_t& rows, ptrdiff_t& cols){
     int maxvalor;
     string linea;
     while (SkipWhitespaces(f) == '#')
       getline(f,linea);
     f >> cols >> rows >> maxvalor;
     
-    if (/*str &&*/ f && rows>0 && rows<5000 && cols>0 && cols<5000){
+    if (/*str &&*/ f && ValidDimensions(rows, cols)){
         f.get(); // Saltamos separador
         return true;
     }
@@ -71,39 +95,410 @@ bool ReadHeader (ifstream& f, int& rows, int& cols){
 
 // _____________________________________________________________________________
 
-unsigned char *ReadPGMImage (const char *path, int& rows, int& cols){
+// Comprueba, antes de reservar, que quedan en el fichero los bytes que anuncia la cabecera:
+// una cabecera corrupta o un fichero truncado no deben provocar una reserva enorme. Si el
+// fichero no es regular (una tubería) no se conoce su tamaño y la lectura decide
+static bool FitsInFile (const char *path, ifstream& f, ptrdiff_t bytes){
+  struct stat info;
+  streamoff position= f.tellg();
+
+  if (stat(path, &info) != 0 || !S_ISREG(info.st_mode) || position < 0)
+    return true;
+  return bytes <= info.st_size - position;
+}
+
+// _____________________________________________________________________________
+
+unsigned char *ReadPGMImage (const char *path, ptrdiff_t& rows, ptrdiff_t& cols){
+  IMAGE_TRACE_SCOPE("ReadPGMImage");
   unsigned char *res=0;
   rows=0;
   cols=0;
   ifstream f(path);
   
   if (ReadKind(f) == IMG_PGM){
-    if (ReadHeader(f, rows, cols)){
-      res= new unsigned char[rows*cols];
-      f.read(reinterpret_cast<char *>(res),rows*cols);
-      if (!f){
-        delete[] res;
+    if (ReadHeader(f, rows, cols) && FitsInFile(path, f, rows*cols)){
+      try{
+        res= AllocateBuffer(rows*cols, "ReadPGMImage");
+      }
+      catch (const bad_alloc&){
         res= 0;
       }
+      if (res){
+        f.read(reinterpret_cast<char *>(res),rows*cols);
+        if (!f){
+          ReleaseBuffer(res);
+          res= 0;
+        }
+      }
+    }
+  }
+  if (!res)
+    rows= cols= 0;
+  return res;
+}
+
+// _____________________________________________________________________________
+
+// Lee un entero no negativo saltando los espacios previos, como f >> n
+bool ParseInt (const char *& p, const char *end, ptrdiff_t& n){
+  while (p<end && isspace(*p))
+    p++;
+  if (p==end || !isdigit(*p))
+    return false;
+
+  n= 0;
+  while (p<end && isdigit(*p)){
+    if (n > (PTRDIFF_MAX - 9) / 10)
+      return false;
+    n= n*10 + (*p++ - '0');
+  }
+  return true;
+}
+
+// _____________________________________________________________________________
+
+// Versión de ReadKind + ReadHeader sobre la proyección: devuelve el desplazamiento de los píxeles
+bool ParseHeader (const char *data, size_t length, ptrdiff_t& rows, ptrdiff_t& cols, size_t& offset){
+  const char *p= data, *end= data+length;
+  ptrdiff_t maxvalor;
+
+  if (length<2 || p[0]!='P' || p[1]!='5')
+    return false;
+  p+= 2;
+
+  for (;;){
+    while (p<end && isspace(*p))
+      p++;
+    if (p==end || *p!='#')
+      break;
+    while (p<end && *p!='\n')
+      p++;
+  }
+
+  if (!ParseInt(p, end, cols) || !ParseInt(p, end, rows) || !ParseInt(p, end, maxvalor))
+    return false;
+  if (p==end || !ValidDimensions(rows, cols))
+    return false;
+
+  offset= (p+1) - data; // Saltamos separador
+  return true;
+}
+
+// _____________________________________________________________________________
+
+unsigned char *MapPGMImage (const char *path, ptrdiff_t& rows, ptrdiff_t& cols, PGMMapping& mapping){
+  IMAGE_TRACE_SCOPE("MapPGMImage");
+  unsigned char *res= 0;
+  struct stat info;
+  size_t offset;
+
+  rows= 0;
+  cols= 0;
+  mapping.base= 0;
+  mapping.length= 0;
+
+  int fd= open(path, O_RDONLY);
+  if (fd<0)
+    return 0;
+
+  if (fstat(fd, &info)==0 && info.st_size>0){
+    size_t length= info.st_size;
+    void *base= mmap(0, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+    if (base!=MAP_FAILED){
+      const char *data= static_cast<const char *>(base);
+
+      if (ParseHeader(data, length, rows, cols, offset) && offset + (size_t)rows*cols <= length){
+        mapping.base= base;
+        mapping.length= length;
+        res= static_cast<unsigned char *>(base) + offset;
+      }
+      else{
+        munmap(base, length);
+        rows= cols= 0;
+      }
     }
   }
+
+  // La proyección sigue siendo válida tras cerrar el descriptor
+  close(fd);
   return res;
 }
 
 // _____________________________________________________________________________
 
+void UnmapPGMImage (PGMMapping& mapping){
+  if (mapping.base)
+    munmap(mapping.base, mapping.length);
+  mapping.base= 0;
+  mapping.length= 0;
+}
+
+// _____________________________________________________________________________
+
 bool WritePGMImage (const char *nombre, const unsigned char *datos,
-                    const int rows, const int cols){
-  ofstream f(nombre);
-  bool res= true;
-  
-  if (f){
-    f << "P5" << endl;
-    f << cols << ' ' << rows << endl;
-    f << 255 << endl;
-    f.write(reinterpret_cast<const char *>(datos),rows*cols);
-    if (!f)
-      res=false;
+                    const ptrdiff_t rows, const ptrdiff_t cols){
+  return WritePGMImage(nombre, datos, rows, cols, cols);
+}
+
+// _____________________________________________________________________________
+
+// Escribe todos los tramos de iov, repitiendo writev tras escrituras parciales o
+// interrupciones. Modifica iov.
+static bool WriteAll (int fd, struct iovec *iov, int count){
+  while (count > 0){
+    ssize_t written= writev(fd, iov, count);
+
+    if (written < 0){
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+
+    while (count > 0 && (size_t) written >= iov->iov_len){
+      written-= iov->iov_len;
+      iov++;
+      count--;
+    }
+    if (count > 0){
+      iov->iov_base= (char *) iov->iov_base + written;
+      iov->iov_len-= written;
+    }
+  }
+  return true;
+}
+
+// Escribe cabecera y píxeles sin copiarlos: cada iovec apunta a la cabecera, a la
+// imagen completa (si es contigua) o a una fila
+static bool WritePGMData (int fd, const unsigned char *datos,
+                          ptrdiff_t rows, ptrdiff_t cols, ptrdiff_t stride){
+  string header= "P5\n" + to_string(cols) + ' ' + to_string(rows) + "\n255\n";
+  vector<struct iovec> iov;
+
+  iov.push_back({(void *) header.data(), header.size()});
+
+  if (stride == cols && (size_t) rows*cols <= (size_t) SSIZE_MAX){
+    iov.push_back({(void *) datos, (size_t) rows*cols});
+    return WriteAll(fd, iov.data(), iov.size());
+  }
+
+  // Filas no consecutivas: como mucho IOV_MAX tramos por llamada, contando la cabecera en
+  // la primera
+  size_t batch= min<ptrdiff_t>(IOV_MAX, max<ptrdiff_t>(2, (SSIZE_MAX - header.size()) / max<ptrdiff_t>(1, cols)));
+  for (ptrdiff_t k=0; k<rows; k++){
+    iov.push_back({(void *) (datos + k*stride), (size_t) cols});
+    if (iov.size() >= batch){
+      if (!WriteAll(fd, iov.data(), iov.size()))
+        return false;
+      iov.clear();
+    }
+  }
+  return iov.empty() || WriteAll(fd, iov.data(), iov.size());
+}
+
+// Sincroniza el directorio que contiene path, para que un renombrado sea persistente
+static bool SyncParentDirectory (const string& path){
+  size_t slash= path.rfind('/');
+  string dir= slash == string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+  int fd= open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+
+  if (fd < 0)
+    return false;
+  bool res= fsync(fd) == 0;
+  close(fd);
+  return res;
+}
+
+// Crea un archivo temporal nuevo junto a target, para que rename no cambie de sistema de
+// archivos. Devuelve su descriptor (o -1) y su nombre en path
+static int OpenTemporary (const string& target, string& path){
+  static atomic<unsigned> counter(0);
+  int fd;
+
+  do{
+    path= target + ".tmp" + to_string(getpid()) + '.' + to_string(counter++);
+    fd= open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+  } while (fd < 0 && errno == EEXIST);
+  return fd;
+}
+
+bool WritePGMImage (const char *nombre, const unsigned char *datos,
+                    const ptrdiff_t rows, const ptrdiff_t cols, const ptrdiff_t stride,
+                    unsigned mode){
+  IMAGE_TRACE_SCOPE("WritePGMImage");
+  string target= nombre, path= target;
+  int fd;
+
+  if (mode & SAVE_ATOMIC)
+    fd= OpenTemporary(target, path);
+  else
+    fd= open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+
+  if (fd < 0)
+    return false;
+
+  bool res= WritePGMData(fd, datos, rows, cols, stride);
+  if (res && (mode & (SAVE_SYNC | SAVE_ATOMIC)))
+    res= fsync(fd) == 0;
+  if (close(fd) != 0)
+    res= false;
+
+  if (mode & SAVE_ATOMIC){
+    if (res)
+      res= rename(path.c_str(), target.c_str()) == 0;
+    if (!res)
+      unlink(path.c_str());
+    else if (mode & SAVE_SYNC)
+      res= SyncParentDirectory(target);
+  }
+  return res;
+}
+
+// _____________________________________________________________________________
+
+PGMRowSource::PGMRowSource (){
+  rows= cols= next_row= 0;
+}
+
+// _____________________________________________________________________________
+
+bool PGMRowSource::Open (const char *path){
+  rows= cols= next_row= 0;
+  file.close();
+  file.clear();
+  file.open(path);
+
+  if (ReadKind(file) == IMG_PGM && ReadHeader(file, rows, cols))
+    return true;
+
+  rows= cols= 0;
+  file.close();
+  return false;
+}
+
+// _____________________________________________________________________________
+
+ptrdiff_t PGMRowSource::get_rows () const{
+  return rows;
+}
+
+// _____________________________________________________________________________
+
+ptrdiff_t PGMRowSource::get_cols () const{
+  return cols;
+}
+
+// _____________________________________________________________________________
+
+ptrdiff_t PGMRowSource::remaining_rows () const{
+  return rows - next_row;
+}
+
+// _____________________________________________________________________________
+
+bool PGMRowSource::ReadRows (unsigned char *buffer, ptrdiff_t count){
+  IMAGE_TRACE_SCOPE("PGMRowSource::ReadRows");
+  if (count > remaining_rows())
+    return false;
+
+  file.read(reinterpret_cast<char *>(buffer), count*cols);
+  next_row+= count;
+  return (bool) file;
+}
+
+// _____________________________________________________________________________
+
+PGMRowSink::PGMRowSink (){
+  rows= cols= written= 0;
+  mode= SAVE_DEFAULT;
+}
+
+// _____________________________________________________________________________
+
+// Un archivo temporal que no llegó a cerrarse con éxito se borra
+PGMRowSink::~PGMRowSink (){
+  if (!temporary.empty()){
+    file.close();
+    unlink(temporary.c_str());
+  }
+}
+
+// _____________________________________________________________________________
+
+bool PGMRowSink::Open (const char *path, ptrdiff_t nrows, ptrdiff_t ncols, unsigned nmode){
+  rows= nrows;
+  cols= ncols;
+  written= 0;
+  mode= nmode;
+  file.close();
+  file.clear();
+  if (!temporary.empty())
+    unlink(temporary.c_str());
+  temporary.clear();
+  target= path;
+
+  // El temporal se crea con O_EXCL y se vuelve a abrir como flujo
+  if (mode & SAVE_ATOMIC){
+    string name;
+    int fd= OpenTemporary(target, name);
+    if (fd < 0)
+      return false;
+    close(fd);
+    temporary= name;
+    file.open(temporary);
+  }
+  else
+    file.open(path);
+
+  if (file){
+    file << "P5" << endl;
+    file << cols << ' ' << rows << endl;
+    file << 255 << endl;
+  }
+  return (bool) file;
+}
+
+// _____________________________________________________________________________
+
+bool PGMRowSink::WriteRows (const unsigned char *buffer, ptrdiff_t count){
+  IMAGE_TRACE_SCOPE("PGMRowSink::WriteRows");
+  if (written + count > rows)
+    return false;
+
+  file.write(reinterpret_cast<const char *>(buffer), count*cols);
+  written+= count;
+  return (bool) file;
+}
+
+// _____________________________________________________________________________
+
+// El flujo no da acceso a su descriptor: para SAVE_SYNC se abre de nuevo el archivo escrito
+static bool SyncFile (const string& path){
+  int fd= open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+  bool res= fsync(fd) == 0;
+  close(fd);
+  return res;
+}
+
+bool PGMRowSink::Close (){
+  bool res= file && written == rows;
+  file.close();
+  res= res && !file.fail();
+
+  if (res && (mode & SAVE_SYNC))
+    res= SyncFile(temporary.empty() ? target : temporary);
+
+  if (!temporary.empty()){
+    if (res)
+      res= rename(temporary.c_str(), target.c_str()) == 0;
+    if (!res)
+      unlink(temporary.c_str());
+    else if (mode & SAVE_SYNC)
+      res= SyncParentDirectory(target);
+    temporary.clear();
   }
   return res;
 }
@@ -0,0 +1,183 @@
+/**
+  * @file imageMemory.cpp
+  * @brief Fichero con definiciones para la gestión de la memoria de los píxeles
+  *
+  */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#include <imageMemory.h>
+
+using namespace std;
+
+static atomic<size_t> allocations(0);
+static atomic<size_t> releases(0);
+static atomic<size_t> allocated_bytes(0);
+static atomic<size_t> current_bytes(0);
+static atomic<size_t> peak_bytes(0);
+
+namespace {
+
+// Contadores de un punto de reserva, identificado por su nombre
+struct SiteCounters {
+  const char *site;
+  atomic<size_t> allocations, releases, bytes, current;
+  SiteCounters *next;
+
+  SiteCounters (const char *name, SiteCounters *after)
+    : site(name), allocations(0), releases(0), bytes(0), current(0), next(after){}
+};
+
+// Cabecera delante de cada buffer, del tamaño de una línea para no perder el alineamiento
+struct BufferHeader {
+  size_t bytes;
+  SiteCounters *site;
+};
+
+}
+
+// Lista de los puntos de reserva, el más reciente primero. Los elementos se añaden al
+// principio y no se liberan nunca, así que se recorre sin cerrojo; sites_lock solo ordena
+// las inserciones para que un nombre no aparezca dos veces
+static atomic<SiteCounters *> sites(0);
+static mutex sites_lock;
+
+static_assert(sizeof(BufferHeader) <= CACHE_LINE_SIZE, "La cabecera no cabe en una linea de cache");
+
+// _____________________________________________________________________________
+
+static void ReportAtExit (){
+  PrintAllocationReport();
+}
+
+// Busca los contadores de un punto de reserva entre first y last (sin incluirlo). Los nombres
+// son literales: casi siempre basta comparar punteros
+static SiteCounters *Search (const char *name, SiteCounters *first, SiteCounters *last){
+  for (SiteCounters *s= first; s != last; s= s->next)
+    if (s->site == name)
+      return s;
+  for (SiteCounters *s= first; s != last; s= s->next)
+    if (strcmp(s->site, name) == 0)
+      return s;
+  return 0;
+}
+
+// Busca o crea los contadores de un punto de reserva. Solo se coge el cerrojo para crearlos;
+// la primera vez se programa además el informe final si lo pide IMAGE_MEMORY_REPORT
+static SiteCounters *FindSite (const char *name){
+  SiteCounters *head= sites.load(memory_order_acquire);
+  SiteCounters *s= Search(name, head, 0);
+  if (s)
+    return s;
+
+  lock_guard<mutex> guard(sites_lock);
+  SiteCounters *now= sites.load(memory_order_relaxed);
+  s= Search(name, now, head);     // solo los añadidos desde la primera búsqueda
+  if (s)
+    return s;
+
+  if (!now && getenv("IMAGE_MEMORY_REPORT"))
+    atexit(ReportAtExit);
+
+  s= new SiteCounters(name, now);
+  sites.store(s, memory_order_release);
+  return s;
+}
+
+// _____________________________________________________________________________
+
+unsigned char *AllocateBuffer (size_t bytes, const char *site){
+  if (bytes == 0)
+    return 0;
+
+  void *res = 0;
+  if (bytes > SIZE_MAX - CACHE_LINE_SIZE || posix_memalign(&res, CACHE_LINE_SIZE, bytes + CACHE_LINE_SIZE) != 0)
+    throw bad_alloc();
+
+  BufferHeader *header= static_cast<BufferHeader *>(res);
+  header->bytes= bytes;
+  header->site= FindSite(site);
+  header->site->allocations.fetch_add(1, memory_order_relaxed);
+  header->site->bytes.fetch_add(bytes, memory_order_relaxed);
+  header->site->current.fetch_add(bytes, memory_order_relaxed);
+
+  allocations.fetch_add(1, memory_order_relaxed);
+  allocated_bytes.fetch_add(bytes, memory_order_relaxed);
+
+  size_t now= current_bytes.fetch_add(bytes, memory_order_relaxed) + bytes;
+  size_t peak= peak_bytes.load(memory_order_relaxed);
+  while (now > peak && !peak_bytes.compare_exchange_weak(peak, now, memory_order_relaxed))
+    ;
+
+  return static_cast<unsigned char *>(res) + CACHE_LINE_SIZE;
+}
+
+// _____________________________________________________________________________
+
+void ReleaseBuffer (unsigned char *buffer){
+  if (buffer == 0)
+    return;
+
+  BufferHeader *header= reinterpret_cast<BufferHeader *>(buffer - CACHE_LINE_SIZE);
+  header->site->releases.fetch_add(1, memory_order_relaxed);
+  header->site->current.fetch_sub(header->bytes, memory_order_relaxed);
+
+  releases.fetch_add(1, memory_order_relaxed);
+  current_bytes.fetch_sub(header->bytes, memory_order_relaxed);
+  free(header);
+}
+
+// _____________________________________________________________________________
+
+AllocationStats GetAllocationStats (){
+  AllocationStats res;
+  res.allocations = allocations.load(memory_order_relaxed);
+  res.releases = releases.load(memory_order_relaxed);
+  res.bytes = allocated_bytes.load(memory_order_relaxed);
+  res.current = current_bytes.load(memory_order_relaxed);
+  res.peak = peak_bytes.load(memory_order_relaxed);
+  return res;
+}
+
+// _____________________________________________________________________________
+
+void ResetPeakAllocation (){
+  peak_bytes.store(current_bytes.load(memory_order_relaxed), memory_order_relaxed);
+}
+
+// _____________________________________________________________________________
+
+vector<AllocationSite> GetAllocationSites (){
+  vector<AllocationSite> res;
+  for (SiteCounters *s= sites.load(memory_order_acquire); s; s= s->next)
+    res.push_back(AllocationSite{s->site, s->allocations.load(memory_order_relaxed),
+                                 s->releases.load(memory_order_relaxed), s->bytes.load(memory_order_relaxed),
+                                 s->current.load(memory_order_relaxed)});
+
+  // La lista empieza por el más reciente
+  reverse(res.begin(), res.end());
+  return res;
+}
+
+// _____________________________________________________________________________
+
+void PrintAllocationReport (){
+  AllocationStats stats= GetAllocationStats();
+
+  fprintf(stderr, "Memoria de imagenes: %zu reservas, %zu liberaciones, %zu bytes reservados, "
+          "pico %zu bytes, %zu bytes sin liberar\n",
+          stats.allocations, stats.releases, stats.bytes, stats.peak, stats.current);
+
+  for (const AllocationSite& s : GetAllocationSites())
+    fprintf(stderr, "   %-24s %10zu reservas %16zu bytes %16zu sin liberar\n",
+            s.site, s.allocations, s.bytes, s.current);
+}
+
+/* Fin Fichero: imageMemory.cpp */
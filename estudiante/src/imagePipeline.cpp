@@ -0,0 +1,333 @@
+/**
+ * @file imagePipeline.cpp
+ * @brief Fichero con definiciones para los métodos de la clase ImagePipeline
+ *
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include <image.h>
+#include <imageIO.h>
+#include <imagePipeline.h>
+#include <imageScale.h>
+#include <imageSimd.h>
+#include <imageThreads.h>
+#include <imageTrace.h>
+
+using namespace std;
+
+// Tamaño aproximado del bloque más grande de la cadena: varios bloques (uno por operación)
+// deben caber a la vez en la caché L2
+static const ptrdiff_t TILE_BYTES = 64 * 1024;
+
+// Tamaño aproximado de cada grupo de filas que se calcula antes de escribirlo en Save
+static const ptrdiff_t CHUNK_BYTES = 4 << 20;
+
+/********************************
+      FUNCIONES PRIVADAS
+********************************/
+
+void ImagePipeline::PushLUT(const byte lut[256]){
+    if (Empty())
+        return;
+
+    // Dos operaciones puntuales seguidas equivalen a una sola tabla: la composición
+    if (!stages.empty() && stages.back().kind == STAGE_LUT){
+        byte * last = stages.back().lut;
+        for (int v = 0; v < 256; v++)
+            last[v] = lut[last[v]];
+        return;
+    }
+
+    Stage stage;
+    stage.kind = STAGE_LUT;
+    stage.row = stage.col = stage.factor = 0;
+    memcpy(stage.lut, lut, 256);
+    stage.rows = rows;
+    stage.cols = cols;
+    stages.push_back(stage);
+}
+
+void ImagePipeline::MakeEmpty(){
+    source = ImageView();
+    stages.clear();
+    rows = cols = 0;
+}
+
+// Se recorre la cadena desde el final: cada fila del resultado de una reducción necesita
+// factor filas de su entrada, y cada fila de una ampliación, media fila (más una)
+ptrdiff_t ImagePipeline::TileRows() const{
+    double scale = 1, widest = 1;
+
+    for (size_t k = stages.size(); k > 0; k--){
+        const Stage & stage = stages[k-1];
+        widest = max(widest, scale * stage.cols);
+
+        if (stage.kind == STAGE_SUBSAMPLE)
+            scale *= stage.factor;
+        else if (stage.kind == STAGE_ZOOM)
+            scale /= 2;
+    }
+
+    ptrdiff_t tile = max<ptrdiff_t>(1, (ptrdiff_t) (TILE_BYTES / widest));
+
+    // Con bloques pares cada fila de una ampliación se calcula una sola vez
+    if (tile > 1)
+        tile &= ~ptrdiff_t(1);
+    return min(tile, max<ptrdiff_t>(1, rows));
+}
+
+ImageView ImagePipeline::Produce(size_t k, ptrdiff_t begin, ptrdiff_t end,
+                                 vector<vector<byte, BufferAllocator<byte>>> & scratch,
+                                 byte * target, ptrdiff_t target_stride) const{
+    ptrdiff_t count = end - begin;
+
+    if (k == 0)
+        return ImageView(source.row(begin), count, source.get_cols(), source.get_stride());
+
+    const Stage & stage = stages[k-1];
+
+    // Los recortes no copian: basta con desplazar la vista de las filas de entrada
+    if (stage.kind == STAGE_CROP)
+        return Produce(k-1, begin + stage.row, end + stage.row, scratch).Crop(0, stage.col, count, stage.cols);
+
+    if (!target){
+        scratch[k].resize(count * stage.cols);
+        target = scratch[k].data();
+        target_stride = stage.cols;
+    }
+    MutableImageView out(target, count, stage.cols, target_stride);
+
+    switch (stage.kind){
+
+        case STAGE_LUT: {
+            ImageView in = Produce(k-1, begin, end, scratch);
+            for (ptrdiff_t i = 0; i < count; i++)
+                ApplyLUTRow(out.row(i), in.row(i), stage.cols, stage.lut);
+            break;
+        }
+
+        case STAGE_SUBSAMPLE: {
+            ImageView in = Produce(k-1, begin * stage.factor, end * stage.factor, scratch);
+            BoxDownsample(in, out, stage.factor);
+            break;
+        }
+
+        case STAGE_ZOOM: {
+            // Las filas pares usan la fila i/2 de la entrada y las impares, también la siguiente
+            ptrdiff_t first = begin / 2;
+            ptrdiff_t last = (end - 1) / 2 + (end - 1) % 2;
+            ImageView in = Produce(k-1, first, last + 1, scratch);
+
+            for (ptrdiff_t i = begin; i < end; i++){
+                if (i%2 == 0)
+                    ZoomEvenRow(out.row(i - begin), in.row(i/2 - first), in.get_cols());
+                else
+                    ZoomOddRow(out.row(i - begin), in.row(i/2 - first), in.row(i/2 + 1 - first), in.get_cols());
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    return out;
+}
+
+// Cada banda de filas se calcula por bloques, con memoria intermedia propia. La última
+// operación escribe directamente en el destino; si es un recorte o no hay operaciones,
+// las filas se copian de la vista que devuelve Produce
+void ImagePipeline::RunRows(ptrdiff_t first, const MutableImageView & dst) const{
+    if (dst.Empty())
+        return;
+
+    ptrdiff_t tile = TileRows();
+
+    ParallelFor(dst.get_rows(), tile, [&](ptrdiff_t begin, ptrdiff_t end){
+        vector<vector<byte, BufferAllocator<byte>>> scratch(stages.size() + 1,
+                                                            vector<byte, BufferAllocator<byte>>(BufferAllocator<byte>("ImagePipeline")));
+
+        for (ptrdiff_t b = begin; b < end; b += tile){
+            ptrdiff_t e = min(b + tile, end);
+            ImageView block = Produce(stages.size(), first + b, first + e, scratch, dst.row(b), dst.get_stride());
+
+            if (block.row(0) != dst.row(b))
+                for (ptrdiff_t i = 0; i < e - b; i++)
+                    memcpy(dst.row(b + i), block.row(i), cols);
+        }
+    });
+}
+
+/********************************
+       FUNCIONES PÚBLICAS
+********************************/
+
+ImagePipeline::ImagePipeline(){
+    rows = cols = 0;
+}
+
+ImagePipeline::ImagePipeline(const ImageView & view) : source(view){
+    rows = view.get_rows();
+    cols = view.get_cols();
+
+    if (view.Empty())
+        MakeEmpty();
+}
+
+ptrdiff_t ImagePipeline::get_rows() const{
+    return rows;
+}
+
+ptrdiff_t ImagePipeline::get_cols() const{
+    return cols;
+}
+
+bool ImagePipeline::Empty() const{
+    return (rows == 0) || (cols == 0);
+}
+
+// Las operaciones puntuales conmutan con los recortes: si antes del recorte solo hay
+// operaciones puntuales, se recorta directamente la vista de origen
+ImagePipeline & ImagePipeline::Crop(ptrdiff_t nrow, ptrdiff_t ncol, ptrdiff_t height, ptrdiff_t width){
+    if (Empty())
+        return *this;
+
+    // Mismo ajuste de la región que ImageView::Crop
+    if (ncol >= cols || nrow >= rows || height <= 0 || width <= 0){
+        MakeEmpty();
+        return *this;
+    }
+    height = min(height, rows - nrow);
+    width = min(width, cols - ncol);
+
+    bool only_luts = true;
+    for (const Stage & stage : stages)
+        only_luts = only_luts && stage.kind == STAGE_LUT;
+
+    if (only_luts){
+        source = source.Crop(nrow, ncol, height, width);
+        for (Stage & stage : stages){
+            stage.rows = height;
+            stage.cols = width;
+        }
+    }
+    else{
+        Stage stage;
+        stage.kind = STAGE_CROP;
+        stage.row = nrow;
+        stage.col = ncol;
+        stage.factor = 0;
+        stage.rows = height;
+        stage.cols = width;
+        stages.push_back(stage);
+    }
+
+    rows = height;
+    cols = width;
+    return *this;
+}
+
+ImagePipeline & ImagePipeline::ApplyLUT(const byte lut[256]){
+    PushLUT(lut);
+    return *this;
+}
+
+ImagePipeline & ImagePipeline::Invert(){
+    byte lut[256];
+    for (int v = 0; v < 256; v++)
+        lut[v] = 255 - v;
+
+    PushLUT(lut);
+    return *this;
+}
+
+ImagePipeline & ImagePipeline::AdjustContrast(byte in1, byte in2, byte out1, byte out2){
+    byte lut[256];
+    ContrastLUT(lut, in1, in2, out1, out2);
+
+    PushLUT(lut);
+    return *this;
+}
+
+// Mismas dimensiones que ImageView::Subsample
+ImagePipeline & ImagePipeline::Subsample(ptrdiff_t factor){
+    if (Empty())
+        return *this;
+
+    if (factor > rows) factor = rows;
+    if (rows / factor == 0 || cols / factor == 0){
+        MakeEmpty();
+        return *this;
+    }
+
+    Stage stage;
+    stage.kind = STAGE_SUBSAMPLE;
+    stage.row = stage.col = 0;
+    stage.factor = factor;
+    stage.rows = rows / factor;
+    stage.cols = cols / factor;
+    stages.push_back(stage);
+
+    rows = stage.rows;
+    cols = stage.cols;
+    return *this;
+}
+
+ImagePipeline & ImagePipeline::Zoom2X(){
+    if (Empty())
+        return *this;
+
+    Stage stage;
+    stage.kind = STAGE_ZOOM;
+    stage.row = stage.col = stage.factor = 0;
+    stage.rows = 2*rows - 1;
+    stage.cols = 2*cols - 1;
+    stages.push_back(stage);
+
+    rows = stage.rows;
+    cols = stage.cols;
+    return *this;
+}
+
+Image ImagePipeline::Run() const{
+    if (Empty())
+        return Image();
+
+    Image result(rows, cols);
+    Run(result.MutableView());
+    return result;
+}
+
+void ImagePipeline::Run(const MutableImageView & dst) const{
+    IMAGE_TRACE_SCOPE("ImagePipeline::Run");
+    RunRows(0, dst);
+}
+
+bool ImagePipeline::Save(const char * file_path) const{
+    IMAGE_TRACE_SCOPE("ImagePipeline::Save");
+    PGMRowSink sink;
+
+    // El origen puede ser la proyección (LOAD_MAP) del propio destino: se escribe en un
+    // temporal que lo sustituye al terminar
+    if (!sink.Open(file_path, rows, cols, SAVE_ATOMIC))
+        return false;
+
+    if (!Empty()){
+        ptrdiff_t chunk = min(rows, max<ptrdiff_t>(1, CHUNK_BYTES / cols));
+        vector<byte> buffer(chunk * cols);
+
+        for (ptrdiff_t b = 0; b < rows; b += chunk){
+            ptrdiff_t count = min(chunk, rows - b);
+            RunRows(b, MutableImageView(buffer.data(), count, cols, cols));
+
+            if (!sink.WriteRows(buffer.data(), count))
+                return false;
+        }
+    }
+
+    return sink.Close();
+}
+
+/* Fin Fichero: imagePipeline.cpp */
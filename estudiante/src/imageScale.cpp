@@ -0,0 +1,240 @@
+/**
+  * @file imageScale.cpp
+  * @brief Fichero con definiciones para los núcleos de cambio de tamaño de imágenes
+  *
+  */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <imageMemory.h>
+#include <imageScale.h>
+#include <imageSimd.h>
+#include <imageThreads.h>
+#include <imageView.h>
+
+using namespace std;
+
+// _____________________________________________________________________________
+// Reducción por bloques
+
+/*
+  Redondeo de la media s/n (n = factor^2) al entero más cercano, con los empates hacia
+  arriba como lround: floor((2s + n) / 2n). Para factores potencia de dos es
+  (s + n/2) >> log2(n). Como s <= 255n, 2s + n no desborda 64 bits mientras la imagen
+  tenga menos de 2^55 píxeles.
+*/
+
+// Suma horizontal de F contadores por bloque, con F conocido al compilar
+template <int F, int SHIFT>
+static void BoxRowFixed (byte *out, const unsigned short *acc, ptrdiff_t width){
+  for (ptrdiff_t j = 0; j < width; j++){
+    const unsigned short *a = acc + j*F;
+    unsigned sum = F*F/2;
+    for (int k = 0; k < F; k++)
+      sum += a[k];
+    out[j] = sum >> SHIFT;
+  }
+}
+
+// Cualquier factor: contadores de 16 bits (hasta 257 filas por bloque) o de 64 bits
+template <typename Acc>
+static void BoxRowGeneric (byte *out, const Acc *acc, ptrdiff_t width, ptrdiff_t factor){
+  const unsigned long long n = (unsigned long long) factor * factor;
+
+  for (ptrdiff_t j = 0; j < width; j++){
+    const Acc *a = acc + j*factor;
+    unsigned long long sum = 0;
+    for (ptrdiff_t k = 0; k < factor; k++)
+      sum += a[k];
+    out[j] = (2*sum + n) / (2*n);
+  }
+}
+
+// Procesa las filas [begin, end) de dst con factor fijo F
+template <int F, int SHIFT>
+static void BoxBandFixed (const ImageView& src, const MutableImageView& dst, ptrdiff_t begin, ptrdiff_t end){
+  const ptrdiff_t used = dst.get_cols() * F;
+  vector<unsigned short, BufferAllocator<unsigned short>> acc(used, 0, BufferAllocator<unsigned short>("BoxDownsample"));
+
+  for (ptrdiff_t i = begin; i < end; i++){
+    fill(acc.begin(), acc.end(), 0);
+    for (int r = 0; r < F; r++)
+      AccumulateRow(acc.data(), src.row(i*F + r), used);
+    BoxRowFixed<F, SHIFT>(dst.row(i), acc.data(), dst.get_cols());
+  }
+}
+
+static void BoxBandGeneric (const ImageView& src, const MutableImageView& dst, ptrdiff_t factor,
+                            ptrdiff_t begin, ptrdiff_t end){
+  const ptrdiff_t used = dst.get_cols() * factor;
+
+  if (factor <= 257){
+    vector<unsigned short, BufferAllocator<unsigned short>> acc(used, 0, BufferAllocator<unsigned short>("BoxDownsample"));
+
+    for (ptrdiff_t i = begin; i < end; i++){
+      fill(acc.begin(), acc.end(), 0);
+      for (ptrdiff_t r = 0; r < factor; r++)
+        AccumulateRow(acc.data(), src.row(i*factor + r), used);
+      BoxRowGeneric(dst.row(i), acc.data(), dst.get_cols(), factor);
+    }
+    return;
+  }
+
+  vector<unsigned long long, BufferAllocator<unsigned long long>> acc(used, 0,
+                                                                     BufferAllocator<unsigned long long>("BoxDownsample"));
+
+  for (ptrdiff_t i = begin; i < end; i++){
+    fill(acc.begin(), acc.end(), 0);
+    for (ptrdiff_t r = 0; r < factor; r++){
+      const byte *p = src.row(i*factor + r);
+      for (ptrdiff_t c = 0; c < used; c++)
+        acc[c] += p[c];
+    }
+    BoxRowGeneric(dst.row(i), acc.data(), dst.get_cols(), factor);
+  }
+}
+
+void BoxDownsample (const ImageView& src, const MutableImageView& dst, ptrdiff_t factor){
+  if (dst.Empty())
+    return;
+
+  // Cada fila de la salida lee factor filas de la entrada
+  ptrdiff_t grain = RowGrain(src.get_cols() * factor);
+
+  ParallelFor(dst.get_rows(), grain, [&](ptrdiff_t begin, ptrdiff_t end){
+    switch (factor){
+      case 2:  BoxBandFixed<2, 2>(src, dst, begin, end); break;
+      case 4:  BoxBandFixed<4, 4>(src, dst, begin, end); break;
+      case 8:  BoxBandFixed<8, 6>(src, dst, begin, end); break;
+      default: BoxBandGeneric(src, dst, factor, begin, end); break;
+    }
+  });
+}
+
+// _____________________________________________________________________________
+// Remuestreo con filtros
+
+// Filtros en función de la distancia al centro, en píxeles de la entrada (sin ensanchar)
+static double FilterRadius (ResizeFilter filter){
+  switch (filter){
+    case RESIZE_BICUBIC:  return 2.0;
+    case RESIZE_LANCZOS3: return 3.0;
+    default:              return 1.0;
+  }
+}
+
+static double FilterValue (ResizeFilter filter, double x){
+  double t = fabs(x);
+
+  switch (filter){
+    case RESIZE_BICUBIC:{
+      const double a = -0.5;
+      if (t < 1.0)
+        return ((a + 2.0)*t - (a + 3.0))*t*t + 1.0;
+      if (t < 2.0)
+        return ((a*t - 5.0*a)*t + 8.0*a)*t - 4.0*a;
+      return 0.0;
+    }
+    case RESIZE_LANCZOS3:{
+      if (t == 0.0)
+        return 1.0;
+      if (t >= 3.0)
+        return 0.0;
+      double px = M_PI * t;
+      return 3.0 * sin(px) * sin(px / 3.0) / (px * px);
+    }
+    default:
+      return t < 1.0 ? 1.0 - t : 0.0;
+  }
+}
+
+// Píxeles y pesos de una dirección: el píxel de salida x combina los taps píxeles de la
+// entrada que empiezan en first[x], con los pesos weights[x*taps ...]
+struct AxisWeights {
+  ptrdiff_t taps;
+  vector<ptrdiff_t> first;
+  vector<short> weights;
+};
+
+/*
+  El píxel i ocupa el intervalo [i, i+1) y su centro está en i + 0.5; el píxel de salida x
+  corresponde al punto (x + 0.5) * in/out de la entrada. taps se redondea a un múltiplo de
+  align (cuando la entrada tiene píxeles suficientes) para que los núcleos vectoriales no
+  tengan resto: los píxeles añadidos quedan fuera del filtro y tienen peso 0.
+*/
+static AxisWeights ComputeWeights (ptrdiff_t in, ptrdiff_t out, ResizeFilter filter, ptrdiff_t align){
+  const double scale = (double) in / out;
+  const double stretch = max(scale, 1.0);
+  const double radius = FilterRadius(filter) * stretch;
+  const int one = 1 << RESAMPLE_BITS;
+
+  AxisWeights res;
+  res.taps = (ptrdiff_t) ceil(2.0 * radius) + 1;
+  res.taps = (res.taps + align - 1) / align * align;
+  res.taps = min(res.taps, in);
+  res.first.resize(out);
+  res.weights.resize(out * res.taps);
+
+  vector<double> w(res.taps);
+
+  for (ptrdiff_t x = 0; x < out; x++){
+    double center = (x + 0.5) * scale;
+    ptrdiff_t first = (ptrdiff_t) floor(center - radius);
+    first = max<ptrdiff_t>(0, min(first, in - res.taps));
+
+    double total = 0.0;
+    for (ptrdiff_t k = 0; k < res.taps; k++){
+      w[k] = FilterValue(filter, (first + k + 0.5 - center) / stretch);
+      total += w[k];
+    }
+
+    // Pesos normalizados en punto fijo; el error de redondeo se suma al mayor para que
+    // la suma sea exactamente 1 y una imagen constante siga siéndolo
+    short *q = &res.weights[x * res.taps];
+    ptrdiff_t largest = 0;
+    int sum = 0;
+    for (ptrdiff_t k = 0; k < res.taps; k++){
+      q[k] = (short) lround(w[k] / total * one);
+      sum += q[k];
+      if (q[k] > q[largest])
+        largest = k;
+    }
+    q[largest] += one - sum;
+    res.first[x] = first;
+  }
+  return res;
+}
+
+void Resample (const ImageView& src, const MutableImageView& dst, ResizeFilter filter){
+  const ptrdiff_t in_rows = src.get_rows(), out_rows = dst.get_rows();
+  const ptrdiff_t out_cols = dst.get_cols();
+
+  AxisWeights horizontal = ComputeWeights(src.get_cols(), out_cols, filter, 8);
+  AxisWeights vertical = ComputeWeights(in_rows, out_rows, filter, 2);
+
+  // Pasada horizontal: solo hacen falta las filas que usa la vertical
+  ptrdiff_t top = vertical.first.front();
+  ptrdiff_t bottom = vertical.first.back() + vertical.taps;
+  vector<byte, BufferAllocator<byte>> temp((size_t)(bottom - top) * out_cols, 0, BufferAllocator<byte>("Resample"));
+
+  ParallelFor(bottom - top, RowGrain(out_cols * horizontal.taps), [&](ptrdiff_t begin, ptrdiff_t end){
+    for (ptrdiff_t i = begin; i < end; i++)
+      ResampleRow(&temp[(size_t)i * out_cols], src.row(top + i), out_cols,
+                  horizontal.first.data(), horizontal.weights.data(), horizontal.taps);
+  });
+
+  // Pasada vertical
+  ParallelFor(out_rows, RowGrain(out_cols * vertical.taps), [&](ptrdiff_t begin, ptrdiff_t end){
+    vector<const byte *> rows(vertical.taps);
+
+    for (ptrdiff_t i = begin; i < end; i++){
+      for (ptrdiff_t k = 0; k < vertical.taps; k++)
+        rows[k] = &temp[(size_t)(vertical.first[i] - top + k) * out_cols];
+      BlendRows(dst.row(i), rows.data(), &vertical.weights[i * vertical.taps], vertical.taps, out_cols);
+    }
+  });
+}
+
+/* Fin Fichero: imageScale.cpp */
@@ -0,0 +1,669 @@
+/**
+  * @file imageSimd.cpp
+  * @brief Fichero con definiciones para los núcleos vectorizados de procesamiento de filas
+  *
+  * Cada núcleo tiene una versión escalar de referencia y versiones para SSE2, AVX2 y
+  * AVX-512 compiladas con atributos target, de forma que el binario funciona en
+  * cualquier procesador x86-64 y solo ejecuta las instrucciones que este soporta.
+  *
+  */
+
+#include <imageSimd.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define IMAGE_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// _____________________________________________________________________________
+// Versiones escalares
+
+static void InvertRowScalar (unsigned char *dst, const unsigned char *src, size_t n){
+  for (size_t k=0; k<n; k++)
+    dst[k] = 255 - src[k];
+}
+
+static void ApplyLUTRowScalar (unsigned char *dst, const unsigned char *src, size_t n,
+                               const unsigned char *lut){
+  size_t k=0;
+
+  for (; k+4<=n; k+=4){
+    unsigned char a = lut[src[k]], b = lut[src[k+1]], c = lut[src[k+2]], d = lut[src[k+3]];
+    dst[k] = a; dst[k+1] = b; dst[k+2] = c; dst[k+3] = d;
+  }
+  for (; k<n; k++)
+    dst[k] = lut[src[k]];
+}
+
+static void AccumulateRowScalar (unsigned short *acc, const unsigned char *src, size_t n){
+  for (size_t k=0; k<n; k++)
+    acc[k] += src[k];
+}
+
+// Las versiones vectoriales dejan siempre al menos el último píxel para estas
+static void ZoomEvenRowScalar (unsigned char *dst, const unsigned char *src, size_t n){
+  for (size_t k=0; k+1<n; k++){
+    dst[2*k] = src[k];
+    dst[2*k+1] = (src[k] + src[k+1] + 1) >> 1;
+  }
+  dst[2*(n-1)] = src[n-1];
+}
+
+static void ZoomOddRowScalar (unsigned char *dst, const unsigned char *a, const unsigned char *b, size_t n){
+  for (size_t k=0; k+1<n; k++){
+    dst[2*k] = (a[k] + b[k] + 1) >> 1;
+    dst[2*k+1] = (a[k] + a[k+1] + b[k] + b[k+1] + 2) >> 2;
+  }
+  dst[2*(n-1)] = (a[n-1] + b[n-1] + 1) >> 1;
+}
+
+// Redondea una suma de productos por pesos de RESAMPLE_BITS bits y la limita a un byte
+static inline unsigned char ResampleRound (int sum){
+  int v = (sum + (1 << (RESAMPLE_BITS-1))) >> RESAMPLE_BITS;
+  return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+static void ResampleRowScalar (unsigned char *dst, const unsigned char *src, size_t n,
+                               const ptrdiff_t *first, const short *weights, size_t taps){
+  for (size_t j=0; j<n; j++){
+    const unsigned char *p = src + first[j];
+    const short *w = weights + j*taps;
+    int sum = 0;
+    for (size_t k=0; k<taps; k++)
+      sum += w[k] * p[k];
+    dst[j] = ResampleRound(sum);
+  }
+}
+
+// Columnas [begin, end) de BlendRows; las versiones vectoriales la usan para el final de la fila
+static void BlendColumns (unsigned char *dst, const unsigned char *const *rows, const short *weights,
+                          size_t taps, size_t begin, size_t end){
+  for (size_t j=begin; j<end; j++){
+    int sum = 0;
+    for (size_t k=0; k<taps; k++)
+      sum += weights[k] * rows[k][j];
+    dst[j] = ResampleRound(sum);
+  }
+}
+
+static void BlendRowsScalar (unsigned char *dst, const unsigned char *const *rows, const short *weights,
+                             size_t taps, size_t n){
+  BlendColumns(dst, rows, weights, taps, 0, n);
+}
+
+static void TransposeBlock16Scalar (unsigned char *dst, ptrdiff_t dst_stride,
+                                    const unsigned char *src, ptrdiff_t src_stride){
+  for (int i=0; i<16; i++)
+    for (int j=0; j<16; j++)
+      dst[j*dst_stride + i] = src[i*src_stride + j];
+}
+
+static void ReverseRowScalar (unsigned char *dst, const unsigned char *src, size_t n){
+  for (size_t k=0; k<n; k++)
+    dst[k] = src[n-1-k];
+}
+
+#ifdef IMAGE_SIMD_X86
+
+// _____________________________________________________________________________
+// Versiones SSE2
+
+__attribute__((target("sse2")))
+static void InvertRowSSE2 (unsigned char *dst, const unsigned char *src, size_t n){
+  const __m128i ones = _mm_set1_epi8(-1);
+  size_t k=0;
+
+  for (; k+16<=n; k+=16){
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src+k));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst+k), _mm_xor_si128(v, ones));
+  }
+  InvertRowScalar(dst+k, src+k, n-k);
+}
+
+__attribute__((target("sse2")))
+static void AccumulateRowSSE2 (unsigned short *acc, const unsigned char *src, size_t n){
+  const __m128i zero = _mm_setzero_si128();
+  size_t k=0;
+
+  for (; k+16<=n; k+=16){
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src+k));
+    __m128i *a = reinterpret_cast<__m128i *>(acc+k);
+    _mm_storeu_si128(a, _mm_add_epi16(_mm_loadu_si128(a), _mm_unpacklo_epi8(v, zero)));
+    _mm_storeu_si128(a+1, _mm_add_epi16(_mm_loadu_si128(a+1), _mm_unpackhi_epi8(v, zero)));
+  }
+  AccumulateRowScalar(acc+k, src+k, n-k);
+}
+
+// Cada iteración lee src[k..k+16] y escribe 32 bytes: 16 píxeles y 16 medias intercalados
+__attribute__((target("sse2")))
+static void ZoomEvenRowSSE2 (unsigned char *dst, const unsigned char *src, size_t n){
+  size_t k=0;
+
+  for (; k+17<=n; k+=16){
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src+k));
+    __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src+k+1));
+    __m128i m = _mm_avg_epu8(x, y);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst+2*k), _mm_unpacklo_epi8(x, m));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst+2*k+16), _mm_unpackhi_epi8(x, m));
+  }
+  ZoomEvenRowScalar(dst+2*k, src+k, n-k);
+}
+
+// Suma de 2x2 más 2, dividida entre 4, sobre 8 columnas ampliadas a 16 bits
+__attribute__((target("sse2")))
+static inline __m128i Mean4SSE2 (__m128i a0, __m128i a1, __m128i b0, __m128i b1){
+  const __m128i two = _mm_set1_epi16(2);
+  __m128i sum = _mm_add_epi16(_mm_add_epi16(a0, a1), _mm_add_epi16(b0, b1));
+  return _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+}
+
+__attribute__((target("sse2")))
+static void ZoomOddRowSSE2 (unsigned char *dst, const unsigned char *a, const unsigned char *b, size_t n){
+  const __m128i zero = _mm_setzero_si128();
+  size_t k=0;
+
+  for (; k+17<=n; k+=16){
+    __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a+k));
+    __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a+k+1));
+    __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b+k));
+    __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b+k+1));
+
+    __m128i vertical = _mm_avg_epu8(a0, b0);
+    __m128i lo = Mean4SSE2(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(a1, zero),
+                           _mm_unpacklo_epi8(b0, zero), _mm_unpacklo_epi8(b1, zero));
+    __m128i hi = Mean4SSE2(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(a1, zero),
+                           _mm_unpackhi_epi8(b0, zero), _mm_unpackhi_epi8(b1, zero));
+    __m128i square = _mm_packus_epi16(lo, hi);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst+2*k), _mm_unpacklo_epi8(vertical, square));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst+2*k+16), _mm_unpackhi_epi8(vertical, square));
+  }
+  ZoomOddRowScalar(dst+2*k, a+k, b+k, n-k);
+}
+
+// Los tramos de 8 píxeles se amplían a 16 bits y se multiplican por sus pesos con pmaddwd;
+// el resto de cada tramo (taps no múltiplo de 8) se suma de forma escalar
+__attribute__((target("sse2")))
+static void ResampleRowSSE2 (unsigned char *dst, const unsigned char *src, size_t n,
+                             const ptrdiff_t *first, const short *weights, size_t taps){
+  if (taps < 8){
+    ResampleRowScalar(dst, src, n, first, weights, taps);
+    return;
+  }
+
+  const __m128i zero = _mm_setzero_si128();
+
+  for (size_t j=0; j<n; j++){
+    const unsigned char *p = src + first[j];
+    const short *w = weights + j*taps;
+    __m128i acc = _mm_setzero_si128();
+    size_t k=0;
+
+    for (; k+8<=taps; k+=8){
+      __m128i pixels = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p+k)), zero);
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(pixels, _mm_loadu_si128(reinterpret_cast<const __m128i *>(w+k))));
+    }
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0x4E));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0xB1));
+
+    int sum = _mm_cvtsi128_si32(acc);
+    for (; k<taps; k++)
+      sum += w[k] * p[k];
+    dst[j] = ResampleRound(sum);
+  }
+}
+
+// Pesos de las filas k y k+1 repetidos en cada par de 16 bits, para pmaddwd
+__attribute__((target("sse2")))
+static inline __m128i WeightPairSSE2 (short w0, short w1){
+  return _mm_set1_epi32((int)(((unsigned)(unsigned short) w1 << 16) | (unsigned short) w0));
+}
+
+__attribute__((target("sse2")))
+static void BlendRowsSSE2 (unsigned char *dst, const unsigned char *const *rows, const short *weights,
+                           size_t taps, size_t n){
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i half = _mm_set1_epi32(1 << (RESAMPLE_BITS-1));
+  size_t j=0;
+
+  for (; j+8<=n; j+=8){
+    __m128i lo = half, hi = half;
+
+    for (size_t k=0; k<taps; k+=2){
+      // Con un número impar de filas la última se empareja consigo misma con peso 0
+      const unsigned char *r1 = k+1 < taps ? rows[k+1] : rows[k];
+      __m128i w = WeightPairSSE2(weights[k], k+1 < taps ? weights[k+1] : 0);
+      __m128i p0 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(rows[k]+j)), zero);
+      __m128i p1 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(r1+j)), zero);
+      lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(p0, p1), w));
+      hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(p0, p1), w));
+    }
+
+    __m128i words = _mm_packs_epi32(_mm_srai_epi32(lo, RESAMPLE_BITS), _mm_srai_epi32(hi, RESAMPLE_BITS));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(dst+j), _mm_packus_epi16(words, words));
+  }
+
+  BlendColumns(dst, rows, weights, taps, j, n);
+}
+
+/*
+  Tras la etapa e (bytes, palabras, dobles y cuádruples palabras), cada registro contiene
+  2^e filas consecutivas de 16/2^e columnas. En la última cada registro es una columna.
+*/
+__attribute__((target("sse2")))
+static void TransposeBlock16SSE2 (unsigned char *dst, ptrdiff_t dst_stride,
+                                  const unsigned char *src, ptrdiff_t src_stride){
+  __m128i x[16], t[16];
+
+  for (int i=0; i<16; i++)
+    x[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i*src_stride));
+
+  for (int i=0; i<8; i++){
+    t[2*i] = _mm_unpacklo_epi8(x[2*i], x[2*i+1]);
+    t[2*i+1] = _mm_unpackhi_epi8(x[2*i], x[2*i+1]);
+  }
+  for (int g=0; g<16; g+=4){
+    x[g] = _mm_unpacklo_epi16(t[g], t[g+2]);
+    x[g+1] = _mm_unpackhi_epi16(t[g], t[g+2]);
+    x[g+2] = _mm_unpacklo_epi16(t[g+1], t[g+3]);
+    x[g+3] = _mm_unpackhi_epi16(t[g+1], t[g+3]);
+  }
+  for (int g=0; g<16; g+=8)
+    for (int k=0; k<4; k++){
+      t[g+2*k] = _mm_unpacklo_epi32(x[g+k], x[g+k+4]);
+      t[g+2*k+1] = _mm_unpackhi_epi32(x[g+k], x[g+k+4]);
+    }
+  for (int k=0; k<8; k++){
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + (2*k)*dst_stride), _mm_unpacklo_epi64(t[k], t[k+8]));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + (2*k+1)*dst_stride), _mm_unpackhi_epi64(t[k], t[k+8]));
+  }
+}
+
+// Sin pshufb (SSSE3), el orden de 16 bytes se invierte por dobles palabras, palabras y bytes
+__attribute__((target("sse2")))
+static inline __m128i Reverse16SSE2 (__m128i v){
+  v = _mm_shuffle_epi32(v, 0x1B);
+  v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+  return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+__attribute__((target("sse2")))
+static void ReverseRowSSE2 (unsigned char *dst, const unsigned char *src, size_t n){
+  size_t k=0;
+
+  for (; k+16<=n; k+=16){
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + n-16-k));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst+k), Reverse16SSE2(v));
+  }
+  ReverseRowScalar(dst+k, src, n-k);
+}
+
+// _____________________________________________________________________________
+// Versiones AVX2
+
+__attribute__((target("avx2")))
+static void InvertRowAVX2 (unsigned char *dst, const unsigned char *src, size_t n){
+  const __m256i ones = _mm256_set1_epi8(-1);
+  size_t k=0;
+
+  for (; k+64<=n; k+=64){
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src+k));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src+k+32));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst+k), _mm256_xor_si256(a, ones));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst+k+32), _mm256_xor_si256(b, ones));
+  }
+  InvertRowSSE2(dst+k, src+k, n-k);
+}
+
+__attribute__((target("avx2")))
+static void AccumulateRowAVX2 (unsigned short *acc, const unsigned char *src, size_t n){
+  size_t k=0;
+
+  for (; k+16<=n; k+=16){
+    __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src+k)));
+    __m256i *a = reinterpret_cast<__m256i *>(acc+k);
+    _mm256_storeu_si256(a, _mm256_add_epi16(_mm256_loadu_si256(a), v));
+  }
+  AccumulateRowScalar(acc+k, src+k, n-k);
+}
+
+/*
+  En AVX2 unpacklo/unpackhi intercalan dentro de cada carril de 128 bits: para que los
+  32 píxeles queden en orden se reordenan los cuartos de 64 bits antes de intercalar.
+*/
+__attribute__((target("avx2")))
+static void ZoomEvenRowAVX2 (unsigned char *dst, const unsigned char *src, size_t n){
+  size_t k=0;
+
+  for (; k+33<=n; k+=32){
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src+k));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src+k+1));
+    __m256i m = _mm256_avg_epu8(x, y);
+    x = _mm256_permute4x64_epi64(x, 0xD8);
+    m = _mm256_permute4x64_epi64(m, 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst+2*k), _mm256_unpacklo_epi8(x, m));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst+2*k+32), _mm256_unpackhi_epi8(x, m));
+  }
+  ZoomEvenRowSSE2(dst+2*k, src+k, n-k);
+}
+
+__attribute__((target("avx2")))
+static void ZoomOddRowAVX2 (unsigned char *dst, const unsigned char *a, const unsigned char *b, size_t n){
+  const __m256i two = _mm256_set1_epi16(2);
+  size_t k=0;
+
+  for (; k+33<=n; k+=32){
+    __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a+k));
+    __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b+k));
+    __m256i vertical = _mm256_permute4x64_epi64(_mm256_avg_epu8(a0, b0), 0xD8);
+
+    // Columnas k..k+15 y k+16..k+31 ampliadas a 16 bits, ya en orden
+    __m256i sum_lo = _mm256_add_epi16(
+        _mm256_add_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a+k))),
+                         _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a+k+1)))),
+        _mm256_add_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b+k))),
+                         _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b+k+1)))));
+    __m256i sum_hi = _mm256_add_epi16(
+        _mm256_add_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a+k+16))),
+                         _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a+k+17)))),
+        _mm256_add_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b+k+16))),
+                         _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b+k+17)))));
+    __m256i lo = _mm256_srli_epi16(_mm256_add_epi16(sum_lo, two), 2);
+    __m256i hi = _mm256_srli_epi16(_mm256_add_epi16(sum_hi, two), 2);
+
+    // packus trabaja por carriles y deja los cuartos en el mismo orden que la permutación
+    // de vertical (columnas 0-7, 16-23, 8-15, 24-31)
+    __m256i square = _mm256_packus_epi16(lo, hi);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst+2*k), _mm256_unpacklo_epi8(vertical, square));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst+2*k+32), _mm256_unpackhi_epi8(vertical, square));
+  }
+  ZoomOddRowSSE2(dst+2*k, a+k, b+k, n-k);
+}
+
+/*
+  Con 16 columnas ampliadas a 16 bits, unpacklo/unpackhi_epi16 emparejan por carriles
+  (columnas 0-3 y 8-11, 4-7 y 12-15), y packs_epi32 las devuelve a su orden.
+*/
+__attribute__((target("avx2")))
+static void BlendRowsAVX2 (unsigned char *dst, const unsigned char *const *rows, const short *weights,
+                           size_t taps, size_t n){
+  const __m256i half = _mm256_set1_epi32(1 << (RESAMPLE_BITS-1));
+  size_t j=0;
+
+  for (; j+16<=n; j+=16){
+    __m256i lo = half, hi = half;
+
+    for (size_t k=0; k<taps; k+=2){
+      const unsigned char *r1 = k+1 < taps ? rows[k+1] : rows[k];
+      short w1 = k+1 < taps ? weights[k+1] : 0;
+      __m256i w = _mm256_set1_epi32((int)(((unsigned)(unsigned short) w1 << 16) | (unsigned short) weights[k]));
+      __m256i p0 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[k]+j)));
+      __m256i p1 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(r1+j)));
+      lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(p0, p1), w));
+      hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(p0, p1), w));
+    }
+
+    __m256i words = _mm256_packs_epi32(_mm256_srai_epi32(lo, RESAMPLE_BITS), _mm256_srai_epi32(hi, RESAMPLE_BITS));
+    __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0x08);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst+j), _mm256_castsi256_si128(bytes));
+  }
+
+  BlendColumns(dst, rows, weights, taps, j, n);
+}
+
+// pshufb invierte cada carril y el cruce de carriles los intercambia
+__attribute__((target("avx2")))
+static void ReverseRowAVX2 (unsigned char *dst, const unsigned char *src, size_t n){
+  const __m256i order = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                         15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  size_t k=0;
+
+  for (; k+32<=n; k+=32){
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + n-32-k));
+    v = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, order), 0x4E);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst+k), v);
+  }
+  ReverseRowSSE2(dst+k, src, n-k);
+}
+
+// _____________________________________________________________________________
+// Versiones AVX-512
+
+__attribute__((target("avx512f,avx512bw,bmi2")))
+static void InvertRowAVX512 (unsigned char *dst, const unsigned char *src, size_t n){
+  const __m512i ones = _mm512_set1_epi8(-1);
+  size_t k=0;
+
+  for (; k+64<=n; k+=64){
+    __m512i v = _mm512_loadu_si512(src+k);
+    _mm512_storeu_si512(dst+k, _mm512_xor_si512(v, ones));
+  }
+
+  // El resto (menos de 64 bytes) se procesa con una carga enmascarada
+  if (k<n){
+    __mmask64 mask = _bzhi_u64(~0ULL, n-k);
+    __m512i v = _mm512_maskz_loadu_epi8(mask, src+k);
+    _mm512_mask_storeu_epi8(dst+k, mask, _mm512_xor_si512(v, ones));
+  }
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void AccumulateRowAVX512 (unsigned short *acc, const unsigned char *src, size_t n){
+  size_t k=0;
+
+  for (; k+32<=n; k+=32){
+    __m512i v = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src+k)));
+    _mm512_storeu_si512(acc+k, _mm512_add_epi16(_mm512_loadu_si512(acc+k), v));
+  }
+  AccumulateRowAVX2(acc+k, src+k, n-k);
+}
+
+/*
+  Con AVX-512 VBMI, vpermi2b consulta una tabla de 128 entradas repartida en dos
+  registros. Dos consultas (mitad baja y mitad alta de la tabla) y una mezcla según el
+  bit 7 del píxel resuelven 64 píxeles.
+*/
+__attribute__((target("avx512f,avx512bw,avx512vbmi,bmi2")))
+static void ApplyLUTRowAVX512 (unsigned char *dst, const unsigned char *src, size_t n,
+                               const unsigned char *lut){
+  const __m512i t0 = _mm512_loadu_si512(lut);
+  const __m512i t1 = _mm512_loadu_si512(lut+64);
+  const __m512i t2 = _mm512_loadu_si512(lut+128);
+  const __m512i t3 = _mm512_loadu_si512(lut+192);
+  size_t k=0;
+
+  for (; k+64<=n; k+=64){
+    __m512i x = _mm512_loadu_si512(src+k);
+    __m512i lo = _mm512_permutex2var_epi8(t0, x, t1);
+    __m512i hi = _mm512_permutex2var_epi8(t2, x, t3);
+    __mmask64 high = _mm512_movepi8_mask(x);
+    _mm512_storeu_si512(dst+k, _mm512_mask_blend_epi8(high, lo, hi));
+  }
+
+  if (k<n){
+    __mmask64 mask = _bzhi_u64(~0ULL, n-k);
+    __m512i x = _mm512_maskz_loadu_epi8(mask, src+k);
+    __m512i lo = _mm512_permutex2var_epi8(t0, x, t1);
+    __m512i hi = _mm512_permutex2var_epi8(t2, x, t3);
+    __mmask64 high = _mm512_movepi8_mask(x);
+    _mm512_mask_storeu_epi8(dst+k, mask, _mm512_mask_blend_epi8(high, lo, hi));
+  }
+}
+
+#endif
+
+// _____________________________________________________________________________
+// Selección de la implementación
+
+/**
+  * @brief Tabla de núcleos de un nivel
+  */
+struct SimdKernels {
+  SimdLevel level;
+  void (*invert)(unsigned char *, const unsigned char *, size_t);
+  void (*lut)(unsigned char *, const unsigned char *, size_t, const unsigned char *);
+  void (*accumulate)(unsigned short *, const unsigned char *, size_t);
+  void (*zoom_even)(unsigned char *, const unsigned char *, size_t);
+  void (*zoom_odd)(unsigned char *, const unsigned char *, const unsigned char *, size_t);
+  void (*resample)(unsigned char *, const unsigned char *, size_t, const ptrdiff_t *, const short *, size_t);
+  void (*blend)(unsigned char *, const unsigned char *const *, const short *, size_t, size_t);
+  void (*transpose16)(unsigned char *, ptrdiff_t, const unsigned char *, ptrdiff_t);
+  void (*reverse)(unsigned char *, const unsigned char *, size_t);
+};
+
+static SimdKernels SelectKernels (SimdLevel level){
+  SimdKernels res;
+  res.level = level;
+  res.invert = InvertRowScalar;
+  res.lut = ApplyLUTRowScalar;
+  res.accumulate = AccumulateRowScalar;
+  res.zoom_even = ZoomEvenRowScalar;
+  res.zoom_odd = ZoomOddRowScalar;
+  res.resample = ResampleRowScalar;
+  res.blend = BlendRowsScalar;
+  res.transpose16 = TransposeBlock16Scalar;
+  res.reverse = ReverseRowScalar;
+
+#ifdef IMAGE_SIMD_X86
+  switch (level){
+    case SIMD_AVX512: res.invert = InvertRowAVX512; res.accumulate = AccumulateRowAVX512; break;
+    case SIMD_AVX2:   res.invert = InvertRowAVX2;   res.accumulate = AccumulateRowAVX2; break;
+    case SIMD_SSE2:   res.invert = InvertRowSSE2;   res.accumulate = AccumulateRowSSE2; break;
+    default: break;
+  }
+
+  // Los núcleos de Zoom2X, remuestreo y trasposición no tienen versión AVX-512 (ResampleRow
+  // y TransposeBlock16 tampoco AVX2): usan la del nivel anterior
+  if (level >= SIMD_SSE2){
+    res.zoom_even = ZoomEvenRowSSE2;
+    res.zoom_odd = ZoomOddRowSSE2;
+    res.resample = ResampleRowSSE2;
+    res.blend = BlendRowsSSE2;
+    res.transpose16 = TransposeBlock16SSE2;
+    res.reverse = ReverseRowSSE2;
+  }
+  if (level >= SIMD_AVX2){
+    res.zoom_even = ZoomEvenRowAVX2;
+    res.zoom_odd = ZoomOddRowAVX2;
+    res.blend = BlendRowsAVX2;
+    res.reverse = ReverseRowAVX2;
+  }
+
+  // vpermi2b requiere VBMI, que no forma parte del nivel AVX-512 (solo F y BW). Sin él se
+  // queda la versión escalar: la consulta con pshufb necesita 16 subtablas por vector y
+  // resultaba más lenta que ella
+  if (level >= SIMD_AVX512 && __builtin_cpu_supports("avx512vbmi"))
+    res.lut = ApplyLUTRowAVX512;
+#endif
+  return res;
+}
+
+static SimdKernels active = SelectKernels(DetectSimdLevel());
+
+// _____________________________________________________________________________
+
+SimdLevel DetectSimdLevel (){
+  SimdLevel res = SIMD_SCALAR;
+
+#ifdef IMAGE_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2"))
+    res = SIMD_SSE2;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2"))
+    res = SIMD_AVX2;
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && res == SIMD_AVX2)
+    res = SIMD_AVX512;
+#endif
+  return res;
+}
+
+// _____________________________________________________________________________
+
+SimdLevel GetSimdLevel (){
+  return active.level;
+}
+
+// _____________________________________________________________________________
+
+SimdLevel SetSimdLevel (SimdLevel level){
+  SimdLevel best = DetectSimdLevel();
+  if (level > best)
+    level = best;
+
+  active = SelectKernels(level);
+  return level;
+}
+
+// _____________________________________________________________________________
+
+const char *SimdLevelName (SimdLevel level){
+  switch (level){
+    case SIMD_SSE2:   return "sse2";
+    case SIMD_AVX2:   return "avx2";
+    case SIMD_AVX512: return "avx512";
+    default:          return "scalar";
+  }
+}
+
+// _____________________________________________________________________________
+
+void InvertRow (unsigned char *dst, const unsigned char *src, size_t n){
+  active.invert(dst, src, n);
+}
+
+// _____________________________________________________________________________
+
+void ApplyLUTRow (unsigned char *dst, const unsigned char *src, size_t n,
+                  const unsigned char *lut){
+  active.lut(dst, src, n, lut);
+}
+
+// _____________________________________________________________________________
+
+void AccumulateRow (unsigned short *acc, const unsigned char *src, size_t n){
+  active.accumulate(acc, src, n);
+}
+
+// _____________________________________________________________________________
+
+void ZoomEvenRow (unsigned char *dst, const unsigned char *src, size_t n){
+  active.zoom_even(dst, src, n);
+}
+
+// _____________________________________________________________________________
+
+void ZoomOddRow (unsigned char *dst, const unsigned char *a, const unsigned char *b, size_t n){
+  active.zoom_odd(dst, a, b, n);
+}
+
+// _____________________________________________________________________________
+
+void ResampleRow (unsigned char *dst, const unsigned char *src, size_t n,
+                  const ptrdiff_t *first, const short *weights, size_t taps){
+  active.resample(dst, src, n, first, weights, taps);
+}
+
+// _____________________________________________________________________________
+
+void BlendRows (unsigned char *dst, const unsigned char *const *rows, const short *weights,
+                size_t taps, size_t n){
+  active.blend(dst, rows, weights, taps, n);
+}
+
+// _____________________________________________________________________________
+
+void TransposeBlock16 (unsigned char *dst, ptrdiff_t dst_stride,
+                       const unsigned char *src, ptrdiff_t src_stride){
+  active.transpose16(dst, dst_stride, src, src_stride);
+}
+
+// _____________________________________________________________________________
+
+void ReverseRow (unsigned char *dst, const unsigned char *src, size_t n){
+  active.reverse(dst, src, n);
+}
+
+/* Fin Fichero: imageSimd.cpp */
@@ -0,0 +1,203 @@
+/**
+  * @file imageStream.cpp
+  * @brief Fichero con definiciones para el procesamiento de imágenes PGM por filas
+  *
+  */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <imageHistogram.h>
+#include <imageIO.h>
+#include <imageSimd.h>
+#include <imageStream.h>
+#include <imageView.h>
+
+using namespace std;
+
+// Tamaño aproximado de cada bloque de filas en las operaciones puntuales
+static const ptrdiff_t CHUNK_BYTES = 1 << 20;
+
+// _____________________________________________________________________________
+
+bool StreamApplyLUT (const char *input, const char *output, const unsigned char lut[256]){
+  PGMRowSource source;
+  PGMRowSink sink;
+
+  if (!source.Open(input) || !sink.Open(output, source.get_rows(), source.get_cols(), SAVE_ATOMIC))
+    return false;
+
+  ptrdiff_t cols= source.get_cols();
+  ptrdiff_t chunk= max<ptrdiff_t>(1, CHUNK_BYTES / cols);
+  vector<unsigned char> buffer(chunk*cols);
+
+  while (source.remaining_rows() > 0){
+    ptrdiff_t count= min(chunk, source.remaining_rows());
+
+    if (!source.ReadRows(buffer.data(), count))
+      return false;
+    ApplyLUTRow(buffer.data(), buffer.data(), count*cols, lut);
+    if (!sink.WriteRows(buffer.data(), count))
+      return false;
+  }
+  return sink.Close();
+}
+
+// _____________________________________________________________________________
+
+bool StreamInvert (const char *input, const char *output){
+  unsigned char lut[256];
+  for (int v=0; v<256; v++)
+    lut[v]= 255 - v;
+
+  return StreamApplyLUT(input, output, lut);
+}
+
+// _____________________________________________________________________________
+
+bool StreamAdjustContrast (const char *input, const char *output,
+                           unsigned char in1, unsigned char in2,
+                           unsigned char out1, unsigned char out2){
+  unsigned char lut[256];
+  ContrastLUT(lut, in1, in2, out1, out2);
+
+  return StreamApplyLUT(input, output, lut);
+}
+
+// _____________________________________________________________________________
+
+// Primera lectura de las operaciones que dependen del histograma
+static bool StreamHistogram (const char *input, ImageHistogram& hist){
+  PGMRowSource source;
+
+  if (!source.Open(input))
+    return false;
+
+  ptrdiff_t cols= source.get_cols();
+  ptrdiff_t chunk= max<ptrdiff_t>(1, CHUNK_BYTES / cols);
+  vector<unsigned char> buffer(chunk*cols);
+
+  while (source.remaining_rows() > 0){
+    ptrdiff_t count= min(chunk, source.remaining_rows());
+
+    if (!source.ReadRows(buffer.data(), count))
+      return false;
+    hist.Add(ImageView(buffer.data(), count, cols, cols));
+  }
+  return true;
+}
+
+// _____________________________________________________________________________
+
+bool StreamAutoContrast (const char *input, const char *output, double low, double high){
+  ImageHistogram hist;
+  unsigned char lut[256];
+
+  if (!StreamHistogram(input, hist))
+    return false;
+  AutoContrastLUT(lut, hist, low, high);
+
+  return StreamApplyLUT(input, output, lut);
+}
+
+// _____________________________________________________________________________
+
+bool StreamEqualize (const char *input, const char *output){
+  ImageHistogram hist;
+  unsigned char lut[256];
+
+  if (!StreamHistogram(input, hist))
+    return false;
+  EqualizeLUT(lut, hist);
+
+  return StreamApplyLUT(input, output, lut);
+}
+
+// _____________________________________________________________________________
+
+bool StreamSubsample (const char *input, const char *output, ptrdiff_t factor){
+  PGMRowSource source;
+  PGMRowSink sink;
+
+  if (!source.Open(input))
+    return false;
+
+  ptrdiff_t rows= source.get_rows();
+  ptrdiff_t cols= source.get_cols();
+
+  // Mismas dimensiones que Image::Subsample
+  if (factor > rows) factor= rows;
+  ptrdiff_t newheight= rows/factor;
+  ptrdiff_t newwidth= cols/factor;
+  if (newheight == 0 || newwidth == 0)
+    newheight= newwidth= 0;
+
+  if (!sink.Open(output, newheight, newwidth, SAVE_ATOMIC))
+    return false;
+
+  vector<unsigned char> line(cols), result(newwidth);
+  vector<unsigned long long> sums(newwidth);
+  double area= (double) factor * factor;
+
+  for (ptrdiff_t i=0; i<newheight; i++){
+    fill(sums.begin(), sums.end(), 0);
+
+    for (ptrdiff_t f=0; f<factor; f++){
+      if (!source.ReadRows(line.data()))
+        return false;
+
+      for (ptrdiff_t j=0; j<newwidth; j++)
+        for (ptrdiff_t c=j*factor; c<(j+1)*factor; c++)
+          sums[j]+= line[c];
+    }
+
+    for (ptrdiff_t j=0; j<newwidth; j++)
+      result[j]= lround(sums[j] / area);
+
+    if (!sink.WriteRows(result.data()))
+      return false;
+  }
+  return sink.Close();
+}
+
+// _____________________________________________________________________________
+
+bool StreamZoom2X (const char *input, const char *output){
+  PGMRowSource source;
+  PGMRowSink sink;
+
+  if (!source.Open(input))
+    return false;
+
+  ptrdiff_t rows= source.get_rows();
+  ptrdiff_t cols= source.get_cols();
+
+  if (!sink.Open(output, 2*rows-1, 2*cols-1, SAVE_ATOMIC))
+    return false;
+
+  vector<unsigned char> previous(cols), current(cols), result(2*cols-1);
+
+  if (!source.ReadRows(current.data()))
+    return false;
+  ZoomEvenRow(result.data(), current.data(), cols);
+  if (!sink.WriteRows(result.data()))
+    return false;
+
+  while (source.remaining_rows() > 0){
+    previous.swap(current);
+    if (!source.ReadRows(current.data()))
+      return false;
+
+    ZoomOddRow(result.data(), previous.data(), current.data(), cols);
+    if (!sink.WriteRows(result.data()))
+      return false;
+
+    ZoomEvenRow(result.data(), current.data(), cols);
+    if (!sink.WriteRows(result.data()))
+      return false;
+  }
+  return sink.Close();
+}
+
+/* Fin Fichero: imageStream.cpp */
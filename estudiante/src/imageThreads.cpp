@@ -0,0 +1,216 @@
+/**
+  * @file imageThreads.cpp
+  * @brief Fichero con definiciones para el reparto de operaciones entre hilos
+  *
+  */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <imageThreads.h>
+#include <imageTrace.h>
+
+using namespace std;
+
+// Bandas por hilo: algo más de una para que los hilos que acaban antes cojan trabajo
+static const ptrdiff_t BANDS_PER_THREAD = 4;
+
+// Bytes mínimos por banda
+static const ptrdiff_t GRAIN_BYTES = 64 * 1024;
+
+namespace {
+
+// Conjunto de hilos que esperan bandas de un ParallelFor. Solo se ejecuta un trabajo a
+// la vez (ver ParallelFor); el hilo que lo lanza también procesa bandas.
+class ThreadPool {
+
+  private:
+
+    vector<thread> workers;
+    mutex lock;
+    condition_variable wake, done;
+
+    // Trabajo en curso. Solo cambia con lock cogido y ningún hilo dentro de Work.
+    const function<void (ptrdiff_t, ptrdiff_t)> *body;
+    ptrdiff_t count, bands;
+    atomic<ptrdiff_t> next;
+    unsigned long generation;
+    bool open;      // se admiten hilos nuevos en el trabajo
+    int active;     // hilos dentro de Work
+    bool stop;
+    exception_ptr error;    // primera excepción de una banda, con lock cogido
+
+    // Si una banda lanza una excepción se guarda la primera y no se reparten más bandas;
+    // Run la relanza cuando han terminado todos los hilos
+    void Work (){
+      ptrdiff_t b;
+      try {
+        while ((b= next++) < bands){
+          IMAGE_TRACE_SCOPE("ParallelFor");
+          (*body)(count*b/bands, count*(b+1)/bands);
+        }
+      }
+      catch (...){
+        lock_guard<mutex> guard(lock);
+        if (!error)
+          error= current_exception();
+        next= bands;
+      }
+    }
+
+    void Loop (){
+      unsigned long seen= 0;
+      unique_lock<mutex> guard(lock);
+
+      for (;;){
+        wake.wait(guard, [&]{ return stop || (open && generation != seen); });
+        if (stop)
+          return;
+
+        seen= generation;
+        active++;
+        guard.unlock();
+        Work();
+        guard.lock();
+        if (--active == 0)
+          done.notify_one();
+      }
+    }
+
+  public:
+
+    explicit ThreadPool (int nworkers){
+      body= 0;
+      count= bands= 0;
+      next= 0;
+      generation= 0;
+      open= false;
+      active= 0;
+      stop= false;
+      for (int k=0; k<nworkers; k++)
+        workers.emplace_back(&ThreadPool::Loop, this);
+    }
+
+    ~ThreadPool (){
+      {
+        lock_guard<mutex> guard(lock);
+        stop= true;
+      }
+      wake.notify_all();
+      for (thread& t : workers)
+        t.join();
+    }
+
+    int size () const{
+      return workers.size() + 1;
+    }
+
+    void Run (ptrdiff_t n, ptrdiff_t nbands, const function<void (ptrdiff_t, ptrdiff_t)>& f){
+      {
+        lock_guard<mutex> guard(lock);
+        body= &f;
+        count= n;
+        bands= nbands;
+        next= 0;
+        generation++;
+        open= true;
+      }
+      wake.notify_all();
+
+      Work();
+
+      // Todas las bandas están cogidas: basta esperar a los hilos que aún las procesan
+      exception_ptr failure;
+      {
+        unique_lock<mutex> guard(lock);
+        open= false;
+        done.wait(guard, [&]{ return active == 0; });
+        swap(failure, error);
+      }
+      if (failure)
+        rethrow_exception(failure);
+    }
+};
+
+}
+
+// _____________________________________________________________________________
+
+static int DefaultThreadCount (){
+  const char *env= getenv("IMAGE_THREADS");
+  if (env){
+    char *end;
+    long n= strtol(env, &end, 10);
+    if (end != env && *end == '\0' && n > 0)
+      return (int) min<long>(n, 1024);
+  }
+
+  unsigned cores= thread::hardware_concurrency();
+  return cores > 0 ? cores : 1;
+}
+
+static atomic<int> configured(0);   // 0 = sin calcular todavía
+static atomic<bool> busy(false);
+
+namespace {
+
+// Deja libre el conjunto de hilos al salir de ParallelFor, también con excepciones
+struct BusyGuard {
+  ~BusyGuard (){ busy= false; }
+};
+
+}
+
+int GetThreadCount (){
+  int n= configured;
+  if (n == 0){
+    n= DefaultThreadCount();
+    configured= n;
+  }
+  return n;
+}
+
+int SetThreadCount (int count){
+  configured= count > 0 ? min(count, 1024) : DefaultThreadCount();
+  return configured;
+}
+
+ptrdiff_t RowGrain (ptrdiff_t cols){
+  return max<ptrdiff_t>(1, GRAIN_BYTES / max<ptrdiff_t>(1, cols));
+}
+
+// _____________________________________________________________________________
+
+void ParallelFor (ptrdiff_t count, ptrdiff_t grain,
+                  const function<void (ptrdiff_t, ptrdiff_t)>& body){
+  if (count <= 0)
+    return;
+
+  int threads= GetThreadCount();
+  ptrdiff_t bands= min<ptrdiff_t>(count / max<ptrdiff_t>(1, grain), threads * BANDS_PER_THREAD);
+
+  bool expected= false;
+  if (threads == 1 || bands <= 1 || !busy.compare_exchange_strong(expected, true)){
+    body(0, count);
+    return;
+  }
+  BusyGuard release;
+
+  // El conjunto se crea la primera vez y se rehace si cambia el número de hilos
+  static unique_ptr<ThreadPool> pool;
+  if (!pool || pool->size() != threads){
+    pool.reset();
+    pool.reset(new ThreadPool(threads - 1));
+  }
+
+  pool->Run(count, bands, body);
+}
+
+/* Fin Fichero: imageThreads.cpp */
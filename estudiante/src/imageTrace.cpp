@@ -0,0 +1,161 @@
+/**
+  * @file imageTrace.cpp
+  * @brief Fichero con definiciones para la traza de ejecución de las operaciones
+  *
+  */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <imageMemory.h>
+#include <imageTrace.h>
+
+using namespace std;
+
+namespace {
+
+// Intervalo terminado
+struct TraceEvent {
+  const char *name;
+  long long start, end;   // nanosegundos desde el origen de la traza
+};
+
+// Buffer circular de un hilo. Solo escribe el hilo propietario: publica cada evento
+// avanzando head, y quien guarda la traza lee hasta el último head publicado.
+struct ThreadTrace {
+  int tid;
+  TraceEvent *events;
+  atomic<unsigned long long> head;
+};
+
+}
+
+atomic<int> trace_state(-1);
+static string trace_path;
+static chrono::steady_clock::time_point origin;
+
+// Buffers de todos los hilos que han registrado algún intervalo. No se liberan nunca:
+// deben sobrevivir a los hilos para guardarse al final
+static mutex registry_lock;
+static vector<ThreadTrace *> *registry= 0;
+
+static thread_local ThreadTrace *local= 0;
+
+// _____________________________________________________________________________
+
+static void SaveAtExit (){
+  if (!SaveTrace(trace_path.c_str()))
+    fprintf(stderr, "Error: No pudo guardarse la traza en %s\n", trace_path.c_str());
+}
+
+// Consulta IMAGE_TRACE una sola vez, aunque llamen varios hilos a la vez
+int InitializeTrace (){
+  static once_flag once;
+  call_once(once, []{
+    const char *env= getenv("IMAGE_TRACE");
+    bool enabled= env && *env;
+    if (enabled){
+      trace_path= env;
+      origin= chrono::steady_clock::now();
+      atexit(SaveAtExit);
+    }
+    trace_state= enabled;
+  });
+  return trace_state;
+}
+
+long long TraceNow (){
+  return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - origin).count();
+}
+
+// Crea el buffer del hilo la primera vez que registra un intervalo
+static ThreadTrace *LocalTrace (){
+  if (!local){
+    ThreadTrace *t= new ThreadTrace;
+    t->events= reinterpret_cast<TraceEvent *>(AllocateBuffer(TRACE_EVENTS_PER_THREAD * sizeof(TraceEvent), "Traza"));
+    t->head= 0;
+
+    lock_guard<mutex> guard(registry_lock);
+    if (!registry)
+      registry= new vector<ThreadTrace *>;
+    t->tid= registry->size() + 1;
+    registry->push_back(t);
+    local= t;
+  }
+  return local;
+}
+
+// _____________________________________________________________________________
+
+void RecordTrace (const char * name, long long start){
+  ThreadTrace *t= LocalTrace();
+  unsigned long long h= t->head.load(memory_order_relaxed);
+  TraceEvent& e= t->events[h % TRACE_EVENTS_PER_THREAD];
+  e.name= name;
+  e.start= start;
+  e.end= TraceNow();
+  t->head.store(h + 1, memory_order_release);
+}
+
+// _____________________________________________________________________________
+
+// Los nombres son literales del programa, pero se escapan por si acaso
+static void WriteString (ofstream& f, const char *s){
+  f << '"';
+  for (; *s; s++){
+    if (*s == '"' || *s == '\\')
+      f << '\\';
+    if ((unsigned char) *s >= 0x20)
+      f << *s;
+  }
+  f << '"';
+}
+
+bool SaveTrace (const char * file_path){
+  ofstream f(file_path);
+  if (!f)
+    return false;
+
+  vector<ThreadTrace *> threads;
+  {
+    lock_guard<mutex> guard(registry_lock);
+    if (registry)
+      threads= *registry;
+  }
+
+  // Tiempos en microsegundos, como espera el formato
+  f << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  f << fixed << setprecision(3);
+  bool first= true;
+
+  for (ThreadTrace *t : threads){
+    // Los hilos se numeran por orden de su primer intervalo
+    f << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t->tid
+      << ",\"args\":{\"name\":\"hilo " << t->tid << "\"}}";
+    first= false;
+
+    unsigned long long head= t->head.load(memory_order_acquire);
+    unsigned long long begin= head > TRACE_EVENTS_PER_THREAD ? head - TRACE_EVENTS_PER_THREAD : 0;
+
+    for (unsigned long long k=begin; k<head; k++){
+      const TraceEvent& e= t->events[k % TRACE_EVENTS_PER_THREAD];
+      f << ",\n{\"name\":";
+      WriteString(f, e.name);
+      f << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << t->tid << ",\"ts\":" << e.start / 1000.0
+        << ",\"dur\":" << (e.end - e.start) / 1000.0 << "}";
+    }
+  }
+
+  f << "\n]}\n";
+  f.close();
+  return !f.fail();
+}
+
+/* Fin Fichero: imageTrace.cpp */
@@ -0,0 +1,88 @@
+/**
+  * @file imageTransform.cpp
+  * @brief Fichero con definiciones para los núcleos de reordenación de píxeles
+  *
+  */
+
+#include <algorithm>
+#include <vector>
+
+#include <imageMemory.h>
+#include <imageSimd.h>
+#include <imageThreads.h>
+#include <imageTransform.h>
+#include <imageView.h>
+
+using namespace std;
+
+// Lado de los bloques del recorrido: 64 filas de 64 bytes caben holgadamente en L1
+static const ptrdiff_t TILE = 64;
+static const ptrdiff_t MICRO = 16;
+
+// _____________________________________________________________________________
+
+// Traspone la región [i0, i1) x [j0, j1) de src
+static void TransposeTile (const ImageView& src, const MutableImageView& dst,
+                           ptrdiff_t i0, ptrdiff_t i1, ptrdiff_t j0, ptrdiff_t j1){
+  const ptrdiff_t dst_stride = dst.get_stride();
+  const ptrdiff_t src_stride = src.get_stride();
+  ptrdiff_t i = i0;
+
+  for (; i + MICRO <= i1; i += MICRO){
+    ptrdiff_t j = j0;
+    for (; j + MICRO <= j1; j += MICRO)
+      TransposeBlock16(dst.row(j) + i, dst_stride, src.row(i) + j, src_stride);
+
+    // Columnas sobrantes del bloque (menos de 16)
+    for (; j < j1; j++)
+      for (ptrdiff_t k = i; k < i + MICRO; k++)
+        dst.row(j)[k] = src.row(k)[j];
+  }
+
+  // Filas sobrantes del bloque (menos de 16)
+  for (; i < i1; i++)
+    for (ptrdiff_t j = j0; j < j1; j++)
+      dst.row(j)[i] = src.row(i)[j];
+}
+
+void Transpose (const ImageView& src, const MutableImageView& dst){
+  const ptrdiff_t rows = src.get_rows(), cols = src.get_cols();
+  const ptrdiff_t bands = (rows + TILE - 1) / TILE;
+
+  // Cada banda de TILE filas del origen escribe TILE columnas distintas del destino
+  ParallelFor(bands, RowGrain(TILE * cols), [&](ptrdiff_t begin, ptrdiff_t end){
+    for (ptrdiff_t b = begin; b < end; b++){
+      ptrdiff_t i0 = b * TILE, i1 = min(rows, i0 + TILE);
+      for (ptrdiff_t j0 = 0; j0 < cols; j0 += TILE)
+        TransposeTile(src, dst, i0, i1, j0, min(cols, j0 + TILE));
+    }
+  });
+}
+
+// _____________________________________________________________________________
+
+void MirrorColumns (const ImageView& src, const MutableImageView& dst){
+  ParallelFor(src.get_rows(), RowGrain(src.get_cols()), [&](ptrdiff_t begin, ptrdiff_t end){
+    for (ptrdiff_t i = begin; i < end; i++)
+      ReverseRow(dst.row(i), src.row(i), src.get_cols());
+  });
+}
+
+// _____________________________________________________________________________
+
+void PermuteColumns (const MutableImageView& view, const ptrdiff_t *perm){
+  const ptrdiff_t cols = view.get_cols();
+
+  ParallelFor(view.get_rows(), RowGrain(cols), [&](ptrdiff_t begin, ptrdiff_t end){
+    vector<byte, BufferAllocator<byte>> saved(cols, 0, BufferAllocator<byte>("PermuteColumns"));
+
+    for (ptrdiff_t i = begin; i < end; i++){
+      byte *p = view.row(i);
+      copy(p, p + cols, saved.begin());
+      for (ptrdiff_t j = 0; j < cols; j++)
+        p[j] = saved[perm[j]];
+    }
+  });
+}
+
+/* Fin Fichero: imageTransform.cpp */
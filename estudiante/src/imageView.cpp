@@ -0,0 +1,335 @@
+/**
+ * @file imageView.cpp
+ * @brief Fichero con definiciones para los métodos de las clases ImageView y MutableImageView
+ *
+ */
+
+#include <atomic>
+#include <cmath>
+
+#include <image.h>
+#include <imageIO.h>
+#include <imageScale.h>
+#include <imageHistogram.h>
+#include <imageSimd.h>
+#include <imageThreads.h>
+#include <imageTrace.h>
+#include <imageTransform.h>
+
+using namespace std;
+
+/********************************
+      FUNCIONES PRIVADAS
+********************************/
+
+void ImageView::Clip(ptrdiff_t nrow, ptrdiff_t ncol, ptrdiff_t & height, ptrdiff_t & width) const{
+
+    if(ncol>= get_cols() || nrow>= get_rows() || height<=0 || width<=0){
+        width = 0;
+        height = 0;
+    }
+
+    else{
+        if(width+ncol> get_cols())
+            width = get_cols()-ncol;
+
+        if(height+nrow> get_rows())
+            height = get_rows()-nrow;
+    }
+}
+
+// El resultado del ajuste de contraste solo depende del valor del píxel: se calcula una vez por valor
+void ContrastLUT(byte lut[256], byte in1, byte in2, byte out1, byte out2){
+    double quotient1 ;
+    if (in1!=0) quotient1= (double)out1 / (double)in1;
+    else quotient1=0;
+
+    double quotient2 = (double)(out2 - out1) / (double)(in2 - in1);
+
+    double quotient3;
+    if (in2!=255) quotient3= (double)(255 - out2) / (double)(255 - in2);
+    else quotient3=0;
+
+    for(int v = 0; v < 256; v++){
+
+        if(v < in1){
+            lut[v] = lround(quotient1 * v);
+        }
+        else{
+            if(v >= in1 && v <= in2){
+                lut[v] = lround(out1 + (quotient2 * (v - in1)));
+            }
+            else{
+                lut[v] = lround(out2 + (quotient3 * (v - in2)));
+            }
+        }
+    }
+}
+
+/********************************
+       FUNCIONES PÚBLICAS
+********************************/
+
+ImageView::ImageView(){
+    origin = 0;
+    rows = cols = stride = 0;
+}
+
+// La vista no modifica los píxeles: solo MutableImageView da acceso de escritura
+ImageView::ImageView(const byte * data, ptrdiff_t nrows, ptrdiff_t ncols, ptrdiff_t nstride){
+    origin = const_cast<byte *>(data);
+    rows = nrows;
+    cols = ncols;
+    stride = nstride;
+}
+
+bool ImageView::Empty() const{
+    return (rows == 0) || (cols == 0);
+}
+
+ptrdiff_t ImageView::get_rows() const{
+    return rows;
+}
+
+ptrdiff_t ImageView::get_cols() const{
+    return cols;
+}
+
+ptrdiff_t ImageView::get_stride() const{
+    return stride;
+}
+
+size_t ImageView::size() const{
+    return get_rows()*get_cols();
+}
+
+byte ImageView::get_pixel(ptrdiff_t i, ptrdiff_t j) const{
+    return origin[i*stride + j];
+}
+
+const byte * ImageView::row(ptrdiff_t i) const{
+    return origin + i*stride;
+}
+
+bool ImageView::Save(const char * file_path, unsigned mode) const{
+    return WritePGMImage(file_path, origin, rows, cols, stride, mode);
+}
+
+// La subvista comparte los píxeles: solo se desplaza el origen
+ImageView ImageView::Crop(ptrdiff_t nrow, ptrdiff_t ncol, ptrdiff_t height, ptrdiff_t width) const{
+    Clip(nrow, ncol, height, width);
+
+    if (height == 0)
+        return ImageView();
+
+    return ImageView(row(nrow) + ncol, height, width, stride);
+}
+
+// Basta con empezar por la última fila y recorrer las filas hacia atrás
+ImageView ImageView::FlipRows() const{
+    if (Empty())
+        return ImageView();
+
+    return ImageView(row(rows-1), rows, cols, -stride);
+}
+
+// Método para calcular el valor medio de los píxeles de un fragmento
+double ImageView::Mean(ptrdiff_t i, ptrdiff_t j, ptrdiff_t height, ptrdiff_t width) const{
+    IMAGE_TRACE_SCOPE("ImageView::Mean");
+    ImageView frag = Crop(i, j, height, width);
+    atomic<unsigned long long> sum(0);
+
+    // Sumas enteras por bandas: el total no depende del orden en que se acumulen
+    ParallelFor(frag.get_rows(), RowGrain(frag.get_cols()), [&](ptrdiff_t begin, ptrdiff_t end){
+        unsigned long long band = 0;
+        for(ptrdiff_t f = begin; f < end; f++){
+            const byte * p = frag.row(f);
+            for (ptrdiff_t c = 0; c < frag.get_cols(); c++)
+                band += p[c];
+        }
+        sum += band;
+    });
+
+    double mean = (double) sum / frag.size();
+    return mean;
+}
+
+// Método para obtener el histograma de la vista
+ImageHistogram ImageView::Histogram() const{
+    IMAGE_TRACE_SCOPE("ImageView::Histogram");
+    return ImageHistogram(*this);
+}
+
+// Método para obtener una imagen con tamaño reducido
+Image ImageView::Subsample(ptrdiff_t factor) const{
+    IMAGE_TRACE_SCOPE("ImageView::Subsample");
+
+    if (Empty())
+        return Image();
+
+    if (factor > get_rows()) factor = get_rows();
+    Image newimage(get_rows()/factor, get_cols()/factor);
+
+    BoxDownsample(*this, newimage.MutableView(), factor);
+    return newimage;
+}
+
+// Método para obtener una imagen aumentada al doble de su tamaño
+Image ImageView::Zoom2X() const{
+    IMAGE_TRACE_SCOPE("ImageView::Zoom2X");
+
+    if (Empty())
+        return Image();
+
+    ptrdiff_t newheight = get_rows()*2-1;
+    ptrdiff_t newwidth = get_cols()*2-1;
+    Image newimage(newheight, newwidth);
+    MutableImageView out = newimage.MutableView();
+
+    // Las filas pares intercalan los píxeles de una fila con sus medias horizontales y las
+    // impares, las medias verticales con las de cada bloque 2x2 (ver ZoomEvenRow y ZoomOddRow)
+    ParallelFor(newheight, RowGrain(newwidth), [&](ptrdiff_t begin, ptrdiff_t end){
+        for (ptrdiff_t i = begin; i < end; i++){
+            if (i%2 == 0)
+                ZoomEvenRow(out.row(i), row(i/2), get_cols());
+            else
+                ZoomOddRow(out.row(i), row(i/2), row(i/2+1), get_cols());
+        }
+    });
+
+    return newimage;
+}
+
+// Método para obtener una imagen escalada a cualquier tamaño
+Image ImageView::Resize(ptrdiff_t new_rows, ptrdiff_t new_cols, ResizeFilter filter) const{
+    IMAGE_TRACE_SCOPE("ImageView::Resize");
+
+    if (Empty() || new_rows <= 0 || new_cols <= 0)
+        return Image();
+
+    Image newimage(new_rows, new_cols);
+    Resample(*this, newimage.MutableView(), filter);
+    return newimage;
+}
+
+// Método para obtener la imagen traspuesta
+Image ImageView::Transpose() const{
+    IMAGE_TRACE_SCOPE("ImageView::Transpose");
+
+    if (Empty())
+        return Image();
+
+    Image newimage(get_cols(), get_rows());
+    ::Transpose(*this, newimage.MutableView());
+    return newimage;
+}
+
+// Los giros de 90 y 270 grados son trasposiciones en las que el origen o el destino se
+// recorren con las filas al revés; el de 180, una inversión de columnas con las filas al revés
+Image ImageView::Rotate(int degrees) const{
+    IMAGE_TRACE_SCOPE("ImageView::Rotate");
+
+    if (Empty())
+        return Image();
+
+    int turns = ((degrees / 90) % 4 + 4) % 4;
+
+    if (turns == 0)
+        return Image(*this);
+
+    if (turns == 2){
+        Image newimage(get_rows(), get_cols());
+        MirrorColumns(FlipRows(), newimage.MutableView());
+        return newimage;
+    }
+
+    Image newimage(get_cols(), get_rows());
+    if (turns == 1)
+        ::Transpose(FlipRows(), newimage.MutableView());
+    else
+        ::Transpose(*this, newimage.MutableView().FlipRows());
+    return newimage;
+}
+
+MutableImageView::MutableImageView() : ImageView(){
+}
+
+MutableImageView::MutableImageView(byte * data, ptrdiff_t nrows, ptrdiff_t ncols, ptrdiff_t nstride)
+    : ImageView(data, nrows, ncols, nstride){
+}
+
+byte * MutableImageView::row(ptrdiff_t i) const{
+    return origin + i*stride;
+}
+
+void MutableImageView::set_pixel(ptrdiff_t i, ptrdiff_t j, byte value) const{
+    origin[i*stride + j] = value;
+}
+
+MutableImageView MutableImageView::Crop(ptrdiff_t nrow, ptrdiff_t ncol, ptrdiff_t height, ptrdiff_t width) const{
+    Clip(nrow, ncol, height, width);
+
+    if (height == 0)
+        return MutableImageView();
+
+    return MutableImageView(row(nrow) + ncol, height, width, stride);
+}
+
+MutableImageView MutableImageView::FlipRows() const{
+    if (Empty())
+        return MutableImageView();
+
+    return MutableImageView(row(rows-1), rows, cols, -stride);
+}
+
+// Método para invertir la tonalidad de los píxeles de la vista
+void MutableImageView::Invert() const{
+    IMAGE_TRACE_SCOPE("MutableImageView::Invert");
+    ParallelFor(get_rows(), RowGrain(get_cols()), [this](ptrdiff_t begin, ptrdiff_t end){
+        // Si las filas son consecutivas, toda la banda es un único tramo
+        if (stride == cols){
+            InvertRow(row(begin), row(begin), (end - begin) * cols);
+            return;
+        }
+
+        for (ptrdiff_t i = begin; i < end; i++)
+            InvertRow(row(i), row(i), get_cols());
+    });
+}
+
+// Método para aplicar una tabla de consulta a los píxeles de la vista
+void MutableImageView::ApplyLUT(const byte lut[256]) const{
+    IMAGE_TRACE_SCOPE("MutableImageView::ApplyLUT");
+    ParallelFor(get_rows(), RowGrain(get_cols()), [this, lut](ptrdiff_t begin, ptrdiff_t end){
+        if (stride == cols){
+            ApplyLUTRow(row(begin), row(begin), (end - begin) * cols, lut);
+            return;
+        }
+
+        for (ptrdiff_t i = begin; i < end; i++)
+            ApplyLUTRow(row(i), row(i), get_cols(), lut);
+    });
+}
+
+// Método para ajustar el contraste de los píxeles de la vista
+void MutableImageView::AdjustContrast(byte in1, byte in2, byte out1, byte out2) const{
+    IMAGE_TRACE_SCOPE("MutableImageView::AdjustContrast");
+    byte lut[256];
+    ContrastLUT(lut, in1, in2, out1, out2);
+    ApplyLUT(lut);
+}
+
+// El histograma es una primera lectura de la vista; la tabla, la segunda
+void MutableImageView::AutoContrast(double low, double high) const{
+    IMAGE_TRACE_SCOPE("MutableImageView::AutoContrast");
+    byte lut[256];
+    AutoContrastLUT(lut, Histogram(), low, high);
+    ApplyLUT(lut);
+}
+
+void MutableImageView::Equalize() const{
+    IMAGE_TRACE_SCOPE("MutableImageView::Equalize");
+    byte lut[256];
+    EqualizeLUT(lut, Histogram());
+    ApplyLUT(lut);
+}
@@ -0,0 +1,281 @@
+//
+// Fichero: imgtool.cpp
+// Aplica una secuencia de operaciones a una imagen PGM: la carga una vez, ejecuta las
+// operaciones en memoria y guarda el resultado una vez, midiendo el tiempo de cada paso
+//
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <image.h>
+
+using namespace std;
+
+// Operación de la secuencia: nombre y argumentos tal como aparecen en la línea de órdenes
+struct Operation {
+    string name;
+    vector<string> args;
+};
+
+// Operaciones admitidas: nombre, argumentos mínimos y máximos, y sintaxis para el mensaje de uso
+struct OperationInfo {
+    const char * name;
+    size_t min_args, max_args;
+    const char * syntax;
+};
+
+const OperationInfo OPERATIONS[] = {
+    {"crop", 4, 4, "crop <fila> <col> <filas> <cols>"},
+    {"invert", 0, 0, "invert"},
+    {"contrast", 4, 4, "contrast <e1> <e2> <s1> <s2>"},
+    {"auto", 0, 2, "auto [<p1> <p2>]"},
+    {"equalize", 0, 0, "equalize"},
+    {"subsample", 1, 1, "subsample <factor>"},
+    {"zoom2x", 0, 0, "zoom2x"},
+    {"resize", 2, 3, "resize <filas> <cols> [bilinear|bicubic|lanczos3]"},
+    {"shuffle", 0, 0, "shuffle"},
+    {"shufflecols", 0, 0, "shufflecols"},
+    {"transpose", 0, 0, "transpose"},
+    {"rotate", 1, 1, "rotate <grados>"}
+};
+
+const OperationInfo * find_operation(const string & name) {
+    for (const OperationInfo & info : OPERATIONS)
+        if (name == info.name)
+            return &info;
+    return 0;
+}
+
+void usage() {
+    cerr << "Uso: imgtool <FichImagenOriginal> <FichImagenDestino> <op> [| <op> ...]\n";
+    cerr << "Operaciones:\n";
+    for (const OperationInfo & info : OPERATIONS)
+        cerr << "    " << info.syntax << "\n";
+    cerr << "Ejemplo: imgtool entrada.pgm salida.pgm \"crop 10 10 200 200 | zoom2x | invert\"\n";
+}
+
+string describe(const Operation & op) {
+    string text = op.name;
+    for (const string & arg : op.args)
+        text += " " + arg;
+    return text;
+}
+
+// Valor de gris entre 0 y 255
+bool gray_level(const string & arg) {
+    long v = stol(arg);
+    return v >= 0 && v <= 255;
+}
+
+// Comprueba los argumentos que no dependen de la imagen: las dimensiones de crop y resize y el
+// factor de subsample deben ser positivos, y la esquina de crop no negativa; los tramos de
+// contrast, niveles de gris crecientes; los percentiles de auto, crecientes entre 0 y 100; y el
+// ángulo de rotate, múltiplo de 90
+bool valid_sizes(const Operation & op) {
+    const vector<string> & a = op.args;
+    try {
+        if (op.name == "crop")
+            return stol(a[0]) >= 0 && stol(a[1]) >= 0 && stol(a[2]) > 0 && stol(a[3]) > 0;
+        if (op.name == "resize")
+            return stol(a[0]) > 0 && stol(a[1]) > 0;
+        if (op.name == "subsample")
+            return stol(a[0]) > 0;
+        if (op.name == "contrast")
+            return gray_level(a[0]) && gray_level(a[1]) && gray_level(a[2]) && gray_level(a[3]) &&
+                   stol(a[0]) < stol(a[1]) && stol(a[2]) < stol(a[3]);
+        if (op.name == "auto" && a.size() == 2)
+            return stod(a[0]) >= 0 && stod(a[0]) < stod(a[1]) && stod(a[1]) <= 100;
+        if (op.name == "rotate")
+            return stol(a[0]) % 90 == 0;
+    }
+    catch (const logic_error &) {
+        return false;
+    }
+    return true;
+}
+
+// Separa los argumentos en operaciones. Cada operación empieza por su nombre; el separador
+// | es opcional y puede ir en un argumento aparte o dentro de uno entre comillas
+bool parse(int argc, char * argv[], vector<Operation> & ops) {
+    vector<string> tokens;
+    for (int k = 0; k < argc; k++) {
+        string arg = argv[k];
+        for (char & c : arg)
+            if (c == '|')
+                c = ' ';
+
+        istringstream words(arg);
+        string word;
+        while (words >> word)
+            tokens.push_back(word);
+    }
+
+    for (const string & token : tokens) {
+        if (find_operation(token))
+            ops.push_back(Operation{token, vector<string>()});
+        else if (ops.empty()) {
+            cerr << "Error: Operacion desconocida: " << token << endl;
+            return false;
+        }
+        else
+            ops.back().args.push_back(token);
+    }
+
+    if (ops.empty()) {
+        cerr << "Error: No se indico ninguna operacion." << endl;
+        return false;
+    }
+
+    for (const Operation & op : ops) {
+        const OperationInfo * info = find_operation(op.name);
+        if (op.args.size() < info->min_args || op.args.size() > info->max_args ||
+            (op.name == "auto" && op.args.size() == 1)) {
+            cerr << "Error: Numero incorrecto de parametros en " << op.name << ". Uso: " << info->syntax << endl;
+            return false;
+        }
+        if (!valid_sizes(op)) {
+            cerr << "Error: Parametro no valido en " << describe(op) << ". Uso: " << info->syntax << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+ResizeFilter parse_filter(const string & name) {
+    if (name == "bilinear")
+        return RESIZE_BILINEAR;
+    if (name == "bicubic")
+        return RESIZE_BICUBIC;
+    if (name == "lanczos3")
+        return RESIZE_LANCZOS3;
+    throw invalid_argument(name);
+}
+
+// Aplica una operación con los métodos de Image
+void run(Image & image, const Operation & op) {
+    const vector<string> & a = op.args;
+
+    // El recorte debe quedar dentro de la imagen: Crop lo ajustaría en silencio
+    if (op.name == "crop") {
+        ptrdiff_t row = stol(a[0]), col = stol(a[1]), height = stol(a[2]), width = stol(a[3]);
+        if (row + height > image.get_rows() || col + width > image.get_cols())
+            throw out_of_range(describe(op));
+        image = Image(image.Crop(row, col, height, width));
+    }
+    else if (op.name == "invert")
+        image.Invert();
+    else if (op.name == "contrast")
+        image.AdjustContrast(stoi(a[0]), stoi(a[1]), stoi(a[2]), stoi(a[3]));
+    else if (op.name == "auto") {
+        if (a.empty())
+            image.AutoContrast();
+        else
+            image.AutoContrast(stod(a[0]), stod(a[1]));
+    }
+    else if (op.name == "equalize")
+        image.Equalize();
+    else if (op.name == "subsample")
+        image = image.Subsample(stol(a[0]));
+    else if (op.name == "zoom2x")
+        image = image.Zoom2X();
+    else if (op.name == "resize")
+        image = image.Resize(stol(a[0]), stol(a[1]), a.size() > 2 ? parse_filter(a[2]) : RESIZE_BILINEAR);
+    else if (op.name == "shuffle")
+        image.ShuffleRows();
+    else if (op.name == "shufflecols")
+        image.ShuffleCols();
+    else if (op.name == "transpose")
+        image = image.Transpose();
+    else if (op.name == "rotate")
+        image = image.Rotate(stoi(a[0]));
+}
+
+// Muestra el tiempo de un paso y las dimensiones de la imagen tras él
+void report(const string & step, chrono::duration<double, milli> elapsed, const Image & image) {
+    cout << "   " << left << setw(32) << step << right << setw(10) << fixed << setprecision(2)
+         << elapsed.count() << " ms   " << image.get_rows() << " filas x " << image.get_cols() << " columnas" << endl;
+}
+
+int main (int argc, char *argv[]) {
+
+    char *origen, *destino; // nombres de los ficheros
+    vector<Operation> ops;
+    Image image;
+
+    // Comprobar validez de la llamada
+    if (argc < 4) {
+        cerr << "Error: Numero incorrecto de parametros.\n";
+        usage();
+        exit(1);
+    }
+
+    // Obtener argumentos
+    origen = argv[1];
+    destino = argv[2];
+    if (!parse(argc - 3, argv + 3, ops)) {
+        usage();
+        exit(1);
+    }
+
+    // Mostramos argumentos
+    cout << endl;
+    cout << "Fichero origen: " << origen << endl;
+    cout << "Fichero resultado: " << destino << endl;
+    cout << endl;
+
+    typedef chrono::steady_clock clock;
+    clock::time_point start = clock::now(), step = start;
+
+    // Leer la imagen del fichero de entrada
+    if (!image.Load(origen, LOAD_MAP)) {
+        cerr << "Error: No pudo leerse la imagen." << endl;
+        cerr << "Terminando la ejecucion del programa." << endl;
+        return 1;
+    }
+    report("cargar", clock::now() - step, image);
+
+    for (const Operation & op : ops) {
+        step = clock::now();
+        try {
+            run(image, op);
+        }
+        catch (const logic_error &) {
+            cerr << "Error: Parametro no valido en " << describe(op) << endl;
+            cerr << "Terminando la ejecucion del programa." << endl;
+            return 1;
+        }
+        report(describe(op), clock::now() - step, image);
+
+        // Una imagen vacía no puede guardarse como PGM válido
+        if (image.Empty()) {
+            cerr << "Error: La operacion " << describe(op) << " produce una imagen vacia." << endl;
+            cerr << "Terminando la ejecucion del programa." << endl;
+            return 1;
+        }
+    }
+
+    // Guardar la imagen resultado en el fichero. Con SAVE_ATOMIC el destino puede ser el
+    // mismo archivo proyectado al cargar
+    step = clock::now();
+    if (!image.Save(destino, SAVE_ATOMIC)) {
+        cerr << "Error: No pudo guardarse la imagen." << endl;
+        cerr << "Terminando la ejecucion del programa." << endl;
+        return 1;
+    }
+    report("guardar", clock::now() - step, image);
+
+    cout << endl;
+    cout << "Tiempo total: " << fixed << setprecision(2)
+         << chrono::duration<double, milli>(clock::now() - start).count() << " ms" << endl;
+    cout << "La imagen se guardo en " << destino << endl;
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file integralImage.cpp
+ * @brief Fichero con definiciones para los métodos de la clase IntegralImage
+ *
+ */
+
+#include <utility>
+
+#include <image.h>
+#include <imageThreads.h>
+#include <integralImage.h>
+
+using namespace std;
+
+/********************************
+      FUNCIONES PRIVADAS
+********************************/
+
+// Mismo ajuste de la región que ImageView::Crop
+void IntegralImage::Clip(ptrdiff_t i, ptrdiff_t j, ptrdiff_t & height, ptrdiff_t & width) const{
+
+    if(j>= cols || i>= rows || height<=0 || width<=0){
+        width = 0;
+        height = 0;
+    }
+
+    else{
+        if(width+j> cols)
+            width = cols-j;
+
+        if(height+i> rows)
+            height = rows-i;
+    }
+}
+
+/********************************
+       FUNCIONES PÚBLICAS
+********************************/
+
+IntegralImage::IntegralImage() : table(BufferAllocator<unsigned long long>("IntegralImage")){
+    rows = cols = 0;
+}
+
+IntegralImage::IntegralImage(const ImageView & view) : table(BufferAllocator<unsigned long long>("IntegralImage")){
+    Build(view);
+}
+
+// Cada posición se obtiene sumando la fila actual acumulada a la posición de la fila anterior
+void IntegralImage::Build(const ImageView & view){
+    rows = view.get_rows();
+    cols = view.get_cols();
+    table.assign((size_t)(rows+1) * (cols+1), 0);
+
+    if (GetThreadCount() > 1 && rows > RowGrain(cols)){
+        BuildParallel(view);
+        return;
+    }
+
+    for (ptrdiff_t i = 0; i < rows; i++){
+        const byte * p = view.row(i);
+        const unsigned long long * up = &table[(size_t)i * (cols+1)];
+        unsigned long long * t = &table[(size_t)(i+1) * (cols+1)];
+        unsigned long long row_sum = 0;
+
+        for (ptrdiff_t j = 0; j < cols; j++){
+            row_sum += p[j];
+            t[j+1] = up[j+1] + row_sum;
+        }
+    }
+}
+
+// Con varios hilos se hacen dos pasadas independientes por bandas: primero se acumula
+// cada fila (bandas de filas) y después cada columna (bandas de columnas)
+void IntegralImage::BuildParallel(const ImageView & view){
+    const ptrdiff_t width = cols + 1;
+
+    ParallelFor(rows, RowGrain(cols), [&](ptrdiff_t begin, ptrdiff_t end){
+        for (ptrdiff_t i = begin; i < end; i++){
+            const byte * p = view.row(i);
+            unsigned long long * t = &table[(size_t)(i+1) * width];
+            unsigned long long row_sum = 0;
+
+            for (ptrdiff_t j = 0; j < cols; j++){
+                row_sum += p[j];
+                t[j+1] = row_sum;
+            }
+        }
+    });
+
+    // Bandas de al menos una línea de caché de columnas, para no compartir líneas
+    ParallelFor(width, 8, [&](ptrdiff_t begin, ptrdiff_t end){
+        for (ptrdiff_t i = 1; i < rows; i++){
+            const unsigned long long * up = &table[(size_t)i * width];
+            unsigned long long * t = &table[(size_t)(i+1) * width];
+
+            for (ptrdiff_t j = begin; j < end; j++)
+                t[j] += up[j];
+        }
+    });
+}
+
+void IntegralImage::Clear(){
+    decltype(table)(table.get_allocator()).swap(table);
+    rows = cols = 0;
+}
+
+void IntegralImage::swap(IntegralImage & other) noexcept{
+    table.swap(other.table);
+    std::swap(rows, other.rows);
+    std::swap(cols, other.cols);
+}
+
+ptrdiff_t IntegralImage::get_rows() const{
+    return rows;
+}
+
+ptrdiff_t IntegralImage::get_cols() const{
+    return cols;
+}
+
+unsigned long long IntegralImage::Sum(ptrdiff_t i, ptrdiff_t j, ptrdiff_t height, ptrdiff_t width) const{
+    Clip(i, j, height, width);
+
+    if (height == 0)
+        return 0;
+
+    const unsigned long long * top = &table[(size_t)i * (cols+1)];
+    const unsigned long long * bottom = &table[(size_t)(i+height) * (cols+1)];
+
+    return bottom[j+width] - bottom[j] - top[j+width] + top[j];
+}
+
+double IntegralImage::Mean(ptrdiff_t i, ptrdiff_t j, ptrdiff_t height, ptrdiff_t width) const{
+    Clip(i, j, height, width);
+
+    return (double) Sum(i, j, height, width) / ((double) height * width);
+}
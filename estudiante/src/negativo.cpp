@@ -7,6 +7,7 @@
 #include <cstdlib>
 
 #include <image.h>
+#include <imageStream.h>
 
 using namespace std;
 
@@ -15,10 +16,17 @@ int main (int argc, char *argv[]){
   char *origen, *destino; // nombres de los ficheros
   Image image;
 
+  // Con --stream la imagen se procesa fila a fila, sin cargarla completa
+  bool stream = argc > 1 && strcmp(argv[1], "--stream") == 0;
+  if (stream){
+    argc--;
+    argv++;
+  }
+
   // Comprobar validez de la llamada
   if (argc != 3){
     cerr << "Error: Numero incorrecto de parametros.\n";
-    cerr << "Uso: negativo <FichImagenOriginal> <FichImagenDestino>\n";
+    cerr << "Uso: negativo [--stream] <FichImagenOriginal> <FichImagenDestino>\n";
     exit (1);
   }
 
@@ -31,6 +39,17 @@ int main (int argc, char *argv[]){
   cout << "Fichero origen: " << origen << endl;
   cout << "Fichero resultado: " << destino << endl;
 
+  if (stream){
+    if (StreamInvert(origen, destino))
+      cout  << "La imagen se guardo en " << destino << endl;
+    else{
+      cerr << "Error: No pudo procesarse la imagen." << endl;
+      cerr << "Terminando la ejecucion del programa." << endl;
+      return 1;
+    }
+    return 0;
+  }
+
   // Leer la imagen del fichero de entrada
   if (!image.Load(origen)){
     cerr << "Error: No pudo leerse la imagen." << endl;
@@ -0,0 +1,113 @@
+//
+// Fichero: prueba_cadena.cpp
+// Comprueba que ImagePipeline da, byte a byte, el mismo resultado que encadenar las
+// operaciones equivalentes de Image, con uno y con varios hilos
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <image.h>
+#include <imagePipeline.h>
+#include <imageThreads.h>
+
+using namespace std;
+
+// Operación de la cadena: tipo y parámetros
+struct Operation {
+    char kind;              // 'c' recorte, 'i' negativo, 'a' contraste, 'l' tabla, 's' reducción, 'z' ampliación
+    ptrdiff_t args[4];
+};
+
+// Tabla de consulta arbitraria, para que la combinación de tablas no sea trivial
+void ScrambleLUT(byte lut[256]) {
+    for (int v = 0; v < 256; v++)
+        lut[v] = (v * 37 + 11) % 256;
+}
+
+// Aplica las operaciones una a una sobre una imagen completa
+Image eager(const Image & image, const vector<Operation> & operations) {
+    Image result = image;
+    byte lut[256];
+    ScrambleLUT(lut);
+
+    for (const Operation & op : operations)
+        switch (op.kind) {
+            case 'c': result = Image(result.Crop(op.args[0], op.args[1], op.args[2], op.args[3])); break;
+            case 'i': result.Invert(); break;
+            case 'a': result.AdjustContrast(op.args[0], op.args[1], op.args[2], op.args[3]); break;
+            case 'l': result.ApplyLUT(lut); break;
+            case 's': result = result.Subsample(op.args[0]); break;
+            case 'z': result = result.Zoom2X(); break;
+        }
+    return result;
+}
+
+// Registra las mismas operaciones en una cadena y la ejecuta
+Image deferred(const Image & image, const vector<Operation> & operations) {
+    ImagePipeline pipeline(image.View());
+    byte lut[256];
+    ScrambleLUT(lut);
+
+    for (const Operation & op : operations)
+        switch (op.kind) {
+            case 'c': pipeline.Crop(op.args[0], op.args[1], op.args[2], op.args[3]); break;
+            case 'i': pipeline.Invert(); break;
+            case 'a': pipeline.AdjustContrast(op.args[0], op.args[1], op.args[2], op.args[3]); break;
+            case 'l': pipeline.ApplyLUT(lut); break;
+            case 's': pipeline.Subsample(op.args[0]); break;
+            case 'z': pipeline.Zoom2X(); break;
+        }
+    return pipeline.Run();
+}
+
+bool same(const Image & a, const Image & b) {
+    if (a.get_rows() != b.get_rows() || a.get_cols() != b.get_cols())
+        return false;
+
+    for (ptrdiff_t i = 0; i < a.get_rows(); i++)
+        for (ptrdiff_t j = 0; j < a.get_cols(); j++)
+            if (a.get_pixel(i, j) != b.get_pixel(i, j))
+                return false;
+    return true;
+}
+
+int main () {
+
+    // Imagen no cuadrada, de dimensiones impares y con contenido distinto en cada píxel
+    const ptrdiff_t ROWS = 301, COLS = 517;
+    Image image(ROWS, COLS);
+    for (ptrdiff_t i = 0; i < ROWS; i++)
+        for (ptrdiff_t j = 0; j < COLS; j++)
+            image.set_pixel(i, j, (i * 31 + j * 17 + i * j) % 256);
+
+    const vector<vector<Operation>> chains = {
+        // Operaciones puntuales seguidas, que se combinan en una sola tabla
+        {{'i'}, {'a', {40, 200, 10, 240}}, {'l'}},
+        // Recorte impar tras operaciones puntuales, que se aplica a la vista de origen
+        {{'i'}, {'l'}, {'c', {7, 13, 151, 201}}, {'s', {3}}, {'z'}},
+        // Ampliaciones con muchos bloques de filas: cada bloque necesita filas del anterior
+        {{'c', {1, 2, 299, 513}}, {'z'}, {'i'}, {'z'}, {'c', {5, 3, 1001, 1999}}, {'s', {5}}},
+        // Reducciones con factores que no dividen las dimensiones
+        {{'s', {2}}, {'a', {0, 128, 255, 0}}, {'c', {3, 3, 51, 77}}, {'z'}, {'s', {3}}},
+        // Recortes que sobrepasan la imagen y recortes de una sola fila o columna
+        {{'c', {250, 400, 1000, 1000}}, {'z'}, {'c', {0, 0, 1, 500}}, {'l'}},
+        {{'z'}, {'c', {11, 0, 600, 1}}, {'i'}},
+        // Recorte fuera de la imagen: resultado vacío
+        {{'l'}, {'c', {ROWS, 0, 10, 10}}, {'z'}}
+    };
+    const int THREADS[] = {1, 4};
+
+    bool ok = true;
+    for (int threads : THREADS) {
+        SetThreadCount(threads);
+        for (size_t k = 0; k < chains.size(); k++)
+            if (!same(eager(image, chains[k]), deferred(image, chains[k]))) {
+                cerr << "Error: La cadena " << k << " da un resultado distinto con " << threads << " hilos" << endl;
+                ok = false;
+            }
+    }
+
+    cout << (ok ? "OK" : "FALLO") << endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,74 @@
+//
+// Fichero: prueba_guardado.cpp
+// Comprueba que las vistas con filas no consecutivas se guardan y se vuelven a leer igual,
+// también cuando tienen más filas de las que admite una sola llamada a writev (IOV_MAX)
+//
+
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <climits>
+#include <unistd.h>
+#include <image.h>
+
+using namespace std;
+
+// Guarda la vista en path con el modo indicado, la carga y la compara píxel a píxel
+bool round_trip(const ImageView & view, const string & path, unsigned mode) {
+    if (!view.Save(path.c_str(), mode)) {
+        cerr << "Error: No pudo guardarse una vista de " << view.get_rows() << " filas (modo " << mode << ")" << endl;
+        return false;
+    }
+
+    Image loaded;
+    if (!loaded.Load(path.c_str())) {
+        cerr << "Error: No pudo leerse la vista guardada (modo " << mode << ")" << endl;
+        return false;
+    }
+
+    if (loaded.get_rows() != view.get_rows() || loaded.get_cols() != view.get_cols()) {
+        cerr << "Error: Dimensiones distintas tras guardar (modo " << mode << ")" << endl;
+        return false;
+    }
+
+    for (ptrdiff_t i = 0; i < view.get_rows(); i++)
+        for (ptrdiff_t j = 0; j < view.get_cols(); j++)
+            if (loaded.get_pixel(i, j) != view.row(i)[j]) {
+                cerr << "Error: Pixel (" << i << "," << j << ") distinto tras guardar (modo " << mode << ")" << endl;
+                return false;
+            }
+
+    return true;
+}
+
+int main () {
+
+    // Más filas que IOV_MAX, con contenido distinto en cada fila y columna
+    const ptrdiff_t ROWS = 2 * IOV_MAX + 500, COLS = 64;
+    Image image(ROWS, COLS);
+    for (ptrdiff_t i = 0; i < ROWS; i++)
+        for (ptrdiff_t j = 0; j < COLS; j++)
+            image.set_pixel(i, j, (i * 7 + j * 13) % 256);
+
+    const char * tmpdir = getenv("TMPDIR");
+    string path = string(tmpdir ? tmpdir : "/tmp") + "/prueba_guardado_" + to_string(getpid()) + ".pgm";
+
+    // Un recorte más estrecho que la imagen tiene filas no consecutivas; FlipRows, separación negativa
+    const ImageView views[] = {
+        image.Crop(10, 5, ROWS - 20, COLS - 10),
+        image.Crop(0, 1, IOV_MAX, COLS - 2),
+        image.Crop(0, 1, IOV_MAX + 1, COLS - 2),
+        image.Crop(0, 0, ROWS, COLS - 1).FlipRows()
+    };
+    const unsigned MODES[] = {SAVE_DEFAULT, SAVE_ATOMIC};
+
+    bool ok = true;
+    for (const ImageView & view : views)
+        for (unsigned mode : MODES)
+            ok = round_trip(view, path, mode) && ok;
+
+    remove(path.c_str());
+
+    cout << (ok ? "OK" : "FALLO") << endl;
+    return ok ? 0 : 1;
+}
@@ -37,7 +37,7 @@ int main (int argc, char *argv[]) {
     cout << "Fichero resultado: " << destino << endl;
 
     // Leer la imagen del fichero de entrada
-    if (!image.Load(origen)) {
+    if (!image.Load(origen, LOAD_MAP)) {
         cerr << "Error: No pudo leerse la imagen." << endl;
         cerr << "Terminando la ejecucion del programa." << endl;
         return 1;
@@ -7,6 +7,7 @@
 #include <cstdlib>
 
 #include <image.h>
+#include <imagePipeline.h>
 
 using namespace std;
 
@@ -38,7 +39,7 @@ int main (int argc, char *argv[]){
     cout << "Fichero resultado: " << destino << endl;
 
     // Leer la imagen del fichero de entrada
-    if (!image.Load(origen)){
+    if (!image.Load(origen, LOAD_MAP)){
         cerr << "Error: No pudo leerse la imagen." << endl;
         cerr << "Terminando la ejecucion del programa." << endl;
         return 1;
@@ -55,7 +56,9 @@ int main (int argc, char *argv[]){
     cout << "El valor de la coordenada y es: " << coordy << endl;
     cout << "El valor del lado es: " << lado << endl;
 
-    Image newimage = image.Crop(coordx,coordy,lado, lado).Zoom2X();
+    // El recorte y el zoom se calculan en una sola pasada al guardar
+    ImagePipeline newimage(image.View());
+    newimage.Crop(coordx,coordy,lado, lado).Zoom2X();
 
     // Mostrar los parametros de la Imagen Resultado
     cout << endl;